@@ -0,0 +1,363 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Structure-of-arrays vectors
+#include "VectorArray.h"
+
+// Bounding volume hierarchy over bounding spheres for ray queries
+//   The tree of axis-aligned boxes is split by the surface area heuristic evaluated on a few bins of the centers, and
+//   its boxes are only refitted when the spheres move, so the tree stays valid at the cost of a looser fit until it is
+//   built again
+class Bvh {
+    // Node of the tree
+    struct Node {
+        // Lower and upper corners of the box
+        GLfloat lower[3], upper[3];
+        // First primitive of a leaf, or the left child of an inner node whose right child follows it
+        std::uint32_t first;
+        // Number of primitives of a leaf, 0 for an inner node
+        std::uint32_t count;
+        // Parent node, the root refers to itself
+        std::uint32_t parent;
+    };
+
+    // Box of the primitives and of their centers while building
+    struct Box {
+        GLfloat lower[3]{INFINITY, INFINITY, INFINITY}, upper[3]{-INFINITY, -INFINITY, -INFINITY};
+
+        // Extend the box by another one
+        void grow(const Box &b) {
+            for (int i = 0; i < 3; ++i) {
+                lower[i] = std::min(lower[i], b.lower[i]);
+                upper[i] = std::max(upper[i], b.upper[i]);
+            }
+        }
+
+        // Extend the box by a point
+        void grow(const GLfloat *p) {
+            for (int i = 0; i < 3; ++i) {
+                lower[i] = std::min(lower[i], p[i]);
+                upper[i] = std::max(upper[i], p[i]);
+            }
+        }
+
+        // Half of the surface area, 0 for an empty box
+        [[nodiscard]] GLfloat area() const {
+            const GLfloat x(upper[0] - lower[0]), y(upper[1] - lower[1]), z(upper[2] - lower[2]);
+            return x < 0.0f ? 0.0f : x * y + y * z + z * x;
+        }
+    };
+
+    // Number of bins the centers are sorted into on each axis
+    static constexpr int bins = 16;
+
+    // Largest number of primitives in a leaf
+    const std::uint32_t leafSize;
+
+    // Nodes, a child always follows its parent
+    std::vector<Node> nodes;
+
+    // Primitives in the order of the leaves
+    std::vector<std::uint32_t> indices;
+
+    // Leaf of each primitive
+    std::vector<std::uint32_t> leaves;
+
+    // Largest number of nodes from the root to a leaf
+    std::uint32_t height{};
+
+    // Nodes waiting to be visited by a query, sized to the height when the tree is built so that no query allocates
+    mutable std::vector<std::uint32_t> pending;
+
+  public:
+    // Nearest intersection of a ray
+    struct Hit {
+        // Index of the sphere hit
+        std::uint32_t index;
+        // Distance along the ray
+        GLfloat distance;
+    };
+
+    // Constructor
+    //   leafSize: Largest number of primitives in a leaf
+    explicit Bvh(std::uint32_t leafSize = 4) : leafSize(std::max(leafSize, 1u)) {}
+
+    // Destructor
+    virtual ~Bvh() = default;
+
+    // Copy prohibition
+    Bvh(const Bvh &) = delete;
+    Bvh &operator=(const Bvh &) = delete;
+
+    // Number of nodes
+    [[nodiscard]] std::size_t size() const { return nodes.size(); }
+
+    // Build the tree
+    //   spheres: Centers of the spheres in x, y and z and radii in w
+    void build(ConstVectorSpan spheres) {
+        const std::uint32_t n(static_cast<std::uint32_t>(spheres.size()));
+        nodes.clear();
+        height = 0;
+        indices.resize(n);
+        leaves.resize(n);
+        for (std::uint32_t i = 0; i < n; ++i) {
+            indices[i] = i;
+        }
+        if (n == 0) {
+            return;
+        }
+
+        // Boxes and centers of the primitives
+        std::vector<Box> boxes(n);
+        std::vector<GLfloat> centers(3 * n);
+        for (std::uint32_t i = 0; i < n; ++i) {
+            const GLfloat c[] = {spheres.x[i], spheres.y[i], spheres.z[i]}, r(spheres.w[i]);
+            for (int j = 0; j < 3; ++j) {
+                boxes[i].lower[j] = c[j] - r;
+                boxes[i].upper[j] = c[j] + r;
+                centers[3 * i + j] = c[j];
+            }
+        }
+
+        // Split the nodes from the root, a node being split covers the primitives from first to first + count
+        nodes.reserve(2 * n / leafSize + 1);
+        nodes.push_back({{}, {}, 0, n, 0});
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> stack{{0, 1}};
+        while (!stack.empty()) {
+            const auto [node, level](stack.back());
+            stack.pop_back();
+            height = std::max(height, level);
+            const std::uint32_t first(nodes[node].first), count(nodes[node].count);
+
+            // Bounds of the primitives and of their centers
+            Box bounds, centroids;
+            for (std::uint32_t i = first; i < first + count; ++i) {
+                bounds.grow(boxes[indices[i]]);
+                centroids.grow(&centers[3 * indices[i]]);
+            }
+            std::copy(bounds.lower, bounds.lower + 3, nodes[node].lower);
+            std::copy(bounds.upper, bounds.upper + 3, nodes[node].upper);
+
+            // Find the cheapest split plane between the bins on every axis
+            int axis(-1), plane(0);
+            GLfloat cost(std::numeric_limits<GLfloat>::infinity());
+            for (int a = 0; a < 3 && count > 1; ++a) {
+                const GLfloat extent(centroids.upper[a] - centroids.lower[a]);
+                if (!(extent > 0.0f)) {
+                    continue;
+                }
+                const GLfloat k(bins / extent);
+                Box binBox[bins];
+                std::uint32_t binCount[bins]{};
+                for (std::uint32_t i = first; i < first + count; ++i) {
+                    const int b(bin(centers[3 * indices[i] + a], centroids.lower[a], k));
+                    binBox[b].grow(boxes[indices[i]]);
+                    ++binCount[b];
+                }
+
+                // Areas and counts on the left of each plane, then sweep from the right
+                GLfloat leftArea[bins - 1];
+                std::uint32_t leftCount[bins - 1];
+                Box left;
+                std::uint32_t sum(0);
+                for (int b = 0; b < bins - 1; ++b) {
+                    left.grow(binBox[b]);
+                    sum += binCount[b];
+                    leftArea[b] = left.area();
+                    leftCount[b] = sum;
+                }
+                Box right;
+                sum = 0;
+                for (int b = bins - 1; b > 0; --b) {
+                    right.grow(binBox[b]);
+                    sum += binCount[b];
+                    const GLfloat c(leftArea[b - 1] * leftCount[b - 1] + right.area() * sum);
+                    if (leftCount[b - 1] > 0 && sum > 0 && c < cost) {
+                        axis = a;
+                        plane = b;
+                        cost = c;
+                    }
+                }
+            }
+
+            // Make a leaf when splitting costs more than intersecting every primitive, one box test is taken as one
+            // primitive test
+            const GLfloat area(bounds.area());
+            if (count <= leafSize && (axis < 0 || area + cost >= area * count)) {
+                continue;
+            }
+
+            // Partition the primitives on the chosen plane, or in the middle when the centers cannot be told apart
+            std::uint32_t middle;
+            if (axis >= 0) {
+                const GLfloat k(bins / (centroids.upper[axis] - centroids.lower[axis]));
+                middle = static_cast<std::uint32_t>(
+                    std::partition(indices.begin() + first, indices.begin() + first + count,
+                                   [&](std::uint32_t i) {
+                                       return bin(centers[3 * i + axis], centroids.lower[axis], k) < plane;
+                                   }) -
+                    indices.begin());
+            } else {
+                middle = first + count / 2;
+            }
+
+            // Add both children
+            const std::uint32_t child(static_cast<std::uint32_t>(nodes.size()));
+            nodes.push_back({{}, {}, first, middle - first, node});
+            nodes.push_back({{}, {}, middle, first + count - middle, node});
+            nodes[node].first = child;
+            nodes[node].count = 0;
+            stack.emplace_back(child + 1, level + 1);
+            stack.emplace_back(child, level + 1);
+        }
+        pending.assign(height + 1, 0);
+
+        // Find the leaf of each primitive for the refits
+        for (std::uint32_t node = 0; node < nodes.size(); ++node) {
+            for (std::uint32_t i = 0; i < nodes[node].count; ++i) {
+                leaves[indices[nodes[node].first + i]] = node;
+            }
+        }
+    }
+
+    // Refit all boxes to spheres that have moved
+    //   spheres: Centers of the spheres in x, y and z and radii in w, in the same order as they were built
+    void refit(ConstVectorSpan spheres) {
+        for (std::size_t node = nodes.size(); node-- > 0;) {
+            fit(spheres, static_cast<std::uint32_t>(node));
+        }
+    }
+
+    // Refit the boxes containing one sphere that has moved
+    //   spheres: Centers of the spheres in x, y and z and radii in w, in the same order as they were built
+    //   index  : Index of the sphere
+    void refit(ConstVectorSpan spheres, std::uint32_t index) {
+        for (std::uint32_t node = leaves[index];; node = nodes[node].parent) {
+            fit(spheres, node);
+            if (node == 0) {
+                break;
+            }
+        }
+    }
+
+    // Find the nearest sphere hit by a ray
+    //   Nearer children are visited first, and the boxes farther than the nearest hit so far are skipped
+    //   spheres  : Centers of the spheres in x, y and z and radii in w, in the same order as they were built
+    //   origin   : Origin of the ray
+    //   direction: Direction of the ray, need not be normalized
+    //   hit      : Storage location of the nearest intersection
+    //   Returns false if the ray hits no sphere in front of its origin
+    bool intersect(ConstVectorSpan spheres, const GLfloat *origin, const GLfloat *direction, Hit &hit) const {
+        const GLfloat length(std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] +
+                                       direction[2] * direction[2]));
+        if (nodes.empty() || !(length > 0.0f)) {
+            return false;
+        }
+        const GLfloat d[] = {direction[0] / length, direction[1] / length, direction[2] / length};
+        const GLfloat inv[] = {1.0f / d[0], 1.0f / d[1], 1.0f / d[2]};
+
+        hit.distance = std::numeric_limits<GLfloat>::infinity();
+        std::uint32_t depth(0);
+        if (enter(nodes[0], origin, inv) < hit.distance) {
+            pending[depth++] = 0;
+        }
+        while (depth > 0) {
+            const Node &node(nodes[pending[--depth]]);
+
+            if (node.count > 0) {
+                // Intersect the spheres of a leaf
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const std::uint32_t k(indices[i]);
+                    const GLfloat m[] = {origin[0] - spheres.x[k], origin[1] - spheres.y[k], origin[2] - spheres.z[k]};
+                    const GLfloat b(m[0] * d[0] + m[1] * d[1] + m[2] * d[2]);
+                    const GLfloat c(m[0] * m[0] + m[1] * m[1] + m[2] * m[2] - spheres.w[k] * spheres.w[k]);
+                    const GLfloat discriminant(b * b - c);
+                    if (discriminant < 0.0f) {
+                        continue;
+                    }
+
+                    // Nearer intersection, or the farther one from inside the sphere
+                    const GLfloat s(std::sqrt(discriminant));
+                    const GLfloat t(-b - s >= 0.0f ? -b - s : -b + s);
+                    if (t >= 0.0f && t < hit.distance) {
+                        hit = {k, t};
+                    }
+                }
+                continue;
+            }
+
+            // Push the farther child first so that the nearer one is popped next
+            const GLfloat t0(enter(nodes[node.first], origin, inv)), t1(enter(nodes[node.first + 1], origin, inv));
+            const bool swap(t1 < t0);
+            const GLfloat nearer(swap ? t1 : t0), farther(swap ? t0 : t1);
+            if (farther < hit.distance) {
+                pending[depth++] = node.first + (swap ? 0 : 1);
+            }
+            if (nearer < hit.distance) {
+                pending[depth++] = node.first + (swap ? 1 : 0);
+            }
+        }
+        return hit.distance < std::numeric_limits<GLfloat>::infinity();
+    }
+
+  private:
+    // Bin of a center
+    //   c    : Coordinate of the center
+    //   lower: Lowest coordinate of the centers
+    //   k    : Number of bins divided by the extent of the centers
+    static int bin(GLfloat c, GLfloat lower, GLfloat k) {
+        return std::min(static_cast<int>((c - lower) * k), bins - 1);
+    }
+
+    // Distance at which a ray enters a box
+    //   origin: Origin of the ray
+    //   inv   : Reciprocals of the normalized direction of the ray
+    //   Returns infinity if the ray misses the box
+    static GLfloat enter(const Node &node, const GLfloat *origin, const GLfloat *inv) {
+        GLfloat tmin(0.0f), tmax(std::numeric_limits<GLfloat>::infinity());
+        for (int i = 0; i < 3; ++i) {
+            // A ray parallel to the slabs is either between them all along or never, which also avoids 0 * infinity
+            if (std::isinf(inv[i])) {
+                if (origin[i] < node.lower[i] || origin[i] > node.upper[i]) {
+                    return std::numeric_limits<GLfloat>::infinity();
+                }
+                continue;
+            }
+            const GLfloat t0((node.lower[i] - origin[i]) * inv[i]), t1((node.upper[i] - origin[i]) * inv[i]);
+            tmin = std::max(tmin, std::min(t0, t1));
+            tmax = std::min(tmax, std::max(t0, t1));
+        }
+        return tmin <= tmax ? tmin : std::numeric_limits<GLfloat>::infinity();
+    }
+
+    // Fit the box of a node to its primitives or its children
+    //   spheres: Centers of the spheres in x, y and z and radii in w
+    //   node   : Index of the node
+    void fit(ConstVectorSpan spheres, std::uint32_t node) {
+        Node &n(nodes[node]);
+        Box box;
+        if (n.count > 0) {
+            for (std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+                const std::uint32_t k(indices[i]);
+                const GLfloat r(spheres.w[k]);
+                const GLfloat lower[] = {spheres.x[k] - r, spheres.y[k] - r, spheres.z[k] - r};
+                const GLfloat upper[] = {spheres.x[k] + r, spheres.y[k] + r, spheres.z[k] + r};
+                box.grow(lower);
+                box.grow(upper);
+            }
+        } else {
+            for (std::uint32_t c = n.first; c < n.first + 2; ++c) {
+                box.grow(nodes[c].lower);
+                box.grow(nodes[c].upper);
+            }
+        }
+        std::copy(box.lower, box.lower + 3, n.lower);
+        std::copy(box.upper, box.upper + 3, n.upper);
+    }
+};
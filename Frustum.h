@@ -0,0 +1,99 @@
+#pragma once
+#include <GL/glew.h>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Transformation matrix
+#include "Matrix.h"
+
+// Structure-of-arrays vectors
+#include "VectorArray.h"
+
+// SIMD operations
+#include "Simd.h"
+
+// View frustum for culling bounding spheres
+//   The six planes are extracted from a projection (times view) transformation matrix (Gribb and Hartmann), so the
+//   spheres are tested in the coordinate system the matrix transforms from
+class Frustum {
+    // Left, right, bottom, top, near and far planes, a x + b y + c z + d is the distance inside
+    GLfloat plane[6][4];
+
+  public:
+    // Constructor
+    //   m: Projection transformation matrix, multiplied by the view transformation matrix to cull in the world
+    template <typename Kind>
+    explicit Frustum(const BasicMatrix<Kind> &m) {
+        for (int p = 0; p < 6; ++p) {
+            // Add or subtract a row of the first three to the fourth row
+            const int row(p / 2);
+            const GLfloat sign(p % 2 == 0 ? 1.0f : -1.0f);
+            for (int i = 0; i < 4; ++i) {
+                plane[p][i] = m[4 * i + 3] + sign * m[4 * i + row];
+            }
+
+            // Normalize so that the plane gives the distance
+            const GLfloat length(std::sqrt(plane[p][0] * plane[p][0] + plane[p][1] * plane[p][1] +
+                                           plane[p][2] * plane[p][2]));
+            for (int i = 0; i < 4; ++i) {
+                plane[p][i] /= length;
+            }
+        }
+    }
+
+    // Whether a bounding sphere may be visible
+    //   x, y, z: Center of the sphere
+    //   r      : Radius of the sphere
+    [[nodiscard]] bool test(GLfloat x, GLfloat y, GLfloat z, GLfloat r) const {
+        for (const GLfloat *const p : plane) {
+            if (p[0] * x + p[1] * y + p[2] * z + p[3] < -r) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Collect the bounding spheres that may be visible
+    //   Four spheres are tested at once against all planes, and only their mask is branched on
+    //   spheres: Centers of the spheres in x, y and z and radii in w
+    //   visible: Storage location of the indices of the visible spheres, at least spheres.size() elements
+    //   Returns the number of visible spheres
+    std::size_t cull(ConstVectorSpan spheres, std::uint32_t *visible) const {
+        // Planes in every lane
+        simd::float4 a[6], b[6], c[6], d[6];
+        for (int p = 0; p < 6; ++p) {
+            a[p] = simd::splat(plane[p][0]);
+            b[p] = simd::splat(plane[p][1]);
+            c[p] = simd::splat(plane[p][2]);
+            d[p] = simd::splat(plane[p][3]);
+        }
+
+        std::size_t count(0), i(0);
+        for (const std::size_t n(spheres.size() & ~std::size_t(3)); i < n; i += 4) {
+            const simd::float4 x(simd::load(&spheres.x[i])), y(simd::load(&spheres.y[i]));
+            const simd::float4 z(simd::load(&spheres.z[i])), r(simd::load(&spheres.w[i]));
+
+            // Smallest distance inside any plane including the radius, negative when outside
+            simd::float4 inside(simd::splat(INFINITY));
+            for (int p = 0; p < 6; ++p) {
+                const simd::float4 distance(simd::madd(a[p], x, simd::madd(b[p], y, simd::madd(c[p], z, d[p]))));
+                inside = simd::min(inside, simd::add(distance, r));
+            }
+
+            // Append the visible ones
+            for (unsigned mask = ~simd::negative(inside) & 15u; mask != 0; mask &= mask - 1) {
+                visible[count++] = static_cast<std::uint32_t>(i + std::countr_zero(mask));
+            }
+        }
+
+        // Remaining spheres
+        for (; i < spheres.size(); ++i) {
+            if (test(spheres.x[i], spheres.y[i], spheres.z[i], spheres.w[i])) {
+                visible[count++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        return count;
+    }
+};
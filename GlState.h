@@ -0,0 +1,309 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Cache of the OpenGL state set through it, which skips the calls that would not change anything
+//   The program has a single context used by one thread, so the cache is shared like the context. Every change of the
+//   state it tracks must go through it, otherwise the cache no longer matches the context. The binding of
+//   GL_ELEMENT_ARRAY_BUFFER belongs to the vertex array object, so it is always issued. The calls issued and skipped
+//   are counted for each frame
+class GlState {
+  public:
+    // Numbers of calls
+    struct Counters {
+        // Calls passed to OpenGL
+        std::uint64_t issued;
+        // Calls left out because they would not change the state
+        std::uint64_t skipped;
+    };
+
+  private:
+    // Value not set through the cache yet
+    static constexpr GLuint unknown = ~0u;
+
+    // Largest uniform variable cached, a 4x4 matrix
+    static constexpr std::size_t uniformSize = 16 * sizeof(GLfloat);
+
+    // Value of a uniform variable
+    struct Uniform {
+        // Number of bytes
+        std::size_t size;
+        // Contents
+        unsigned char data[uniformSize];
+    };
+
+    // Tracked state
+    struct State {
+        // Current program object
+        GLuint program{unknown};
+        // Bound vertex array object
+        GLuint vertexArray{unknown};
+        // Buffer objects bound to each target
+        std::vector<std::pair<GLenum, GLuint>> buffers;
+        // Buffer objects bound to each indexed binding point by target and index
+        std::vector<std::pair<std::uint64_t, GLuint>> indexedBuffers;
+        // Whether each capability is enabled
+        std::vector<std::pair<GLenum, GLuint>> capabilities;
+        // Face culled, front face winding and depth comparison
+        GLuint cullFace{unknown}, frontFace{unknown}, depthFunc{unknown};
+        // Primitive restart index, which starts at 0 like in the context since every value is a valid index
+        GLuint restartIndex{0};
+        // Uniform variables by program object and location
+        std::unordered_map<std::uint64_t, Uniform> uniforms;
+        // Calls of the current frame
+        Counters counters{};
+    };
+
+    // State of the context
+    static State &state() {
+        static State s;
+        return s;
+    }
+
+    // Record a new value
+    //   current: Cached value, replaced by value
+    //   value  : New value
+    //   Returns true if the call must be issued
+    static bool change(GLuint &current, GLuint value) {
+        Counters &counters(state().counters);
+        if (current == value) {
+            ++counters.skipped;
+            return false;
+        }
+        current = value;
+        ++counters.issued;
+        return true;
+    }
+
+    // Cached value of a target
+    //   values: Cached values by target, the target is added if not found
+    //   target: Target, or target and index of an indexed binding point
+    template <typename Key>
+    static GLuint &cached(std::vector<std::pair<Key, GLuint>> &values, Key target) {
+        auto v(std::find_if(values.begin(), values.end(), [&](const auto &p) { return p.first == target; }));
+        if (v == values.end()) {
+            v = values.emplace(values.end(), target, unknown);
+        }
+        return v->second;
+    }
+
+    // Record a new value of a target
+    //   values: Cached values by target, the target is added if not found
+    //   target: Target, or target and index of an indexed binding point
+    //   value : New value
+    //   Returns true if the call must be issued
+    template <typename Key>
+    static bool change(std::vector<std::pair<Key, GLuint>> &values, Key target, GLuint value) {
+        return change(cached(values, target), value);
+    }
+
+    // Record a new value of a uniform variable of the current program object
+    //   location: Location of the uniform variable, nothing is set at -1
+    //   value   : New value
+    //   size    : Number of bytes of the value
+    //   Returns true if the call must be issued
+    static bool change(GLint location, const void *value, std::size_t size) {
+        State &s(state());
+        if (location < 0) {
+            ++s.counters.skipped;
+            return false;
+        }
+        if (s.program == unknown) {
+            ++s.counters.issued;
+            return true;
+        }
+        Uniform &u(s.uniforms[static_cast<std::uint64_t>(s.program) << 32 | static_cast<GLuint>(location)]);
+        if (u.size == size && std::memcmp(u.data, value, size) == 0) {
+            ++s.counters.skipped;
+            return false;
+        }
+        u.size = size;
+        std::memcpy(u.data, value, size);
+        ++s.counters.issued;
+        return true;
+    }
+
+  public:
+    // Use a program object
+    //   program: Program object name
+    static void useProgram(GLuint program) {
+        if (change(state().program, program)) {
+            glUseProgram(program);
+        }
+    }
+
+    // Current program object set through the cache, without querying the context
+    [[nodiscard]] static GLuint getProgram() {
+        const GLuint program(state().program);
+        return program == unknown ? 0 : program;
+    }
+
+    // Bind a vertex array object
+    //   vao: Vertex array object name
+    static void bindVertexArray(GLuint vao) {
+        if (change(state().vertexArray, vao)) {
+            glBindVertexArray(vao);
+        }
+    }
+
+    // Bind a buffer object
+    //   target: Target of the binding
+    //   buffer: Buffer object name
+    static void bindBuffer(GLenum target, GLuint buffer) {
+        if (target == GL_ELEMENT_ARRAY_BUFFER) {
+            ++state().counters.issued;
+            glBindBuffer(target, buffer);
+        } else if (change(state().buffers, target, buffer)) {
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    // Bind a buffer object to an indexed binding point, which also binds it to the target when issued
+    //   target: Target of the binding
+    //   index : Binding point
+    //   buffer: Buffer object name
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        State &s(state());
+        if (change(s.indexedBuffers, static_cast<std::uint64_t>(target) << 32 | index, buffer)) {
+            glBindBufferBase(target, index, buffer);
+            cached(s.buffers, target) = buffer;
+        }
+    }
+
+    // Enable a capability
+    //   capability: Capability such as GL_CULL_FACE
+    static void enable(GLenum capability) {
+        if (change(state().capabilities, capability, GL_TRUE)) {
+            glEnable(capability);
+        }
+    }
+
+    // Disable a capability
+    //   capability: Capability such as GL_CULL_FACE
+    static void disable(GLenum capability) {
+        if (change(state().capabilities, capability, GL_FALSE)) {
+            glDisable(capability);
+        }
+    }
+
+    // Select the face culled
+    //   mode: GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+    static void cullFace(GLenum mode) {
+        if (change(state().cullFace, mode)) {
+            glCullFace(mode);
+        }
+    }
+
+    // Select the winding of the front face
+    //   mode: GL_CW or GL_CCW
+    static void frontFace(GLenum mode) {
+        if (change(state().frontFace, mode)) {
+            glFrontFace(mode);
+        }
+    }
+
+    // Select the depth comparison
+    //   func: Comparison function such as GL_LESS
+    static void depthFunc(GLenum func) {
+        if (change(state().depthFunc, func)) {
+            glDepthFunc(func);
+        }
+    }
+
+    // Select the index restarting a primitive
+    //   index: Restart index
+    static void primitiveRestartIndex(GLuint index) {
+        if (change(state().restartIndex, index)) {
+            glPrimitiveRestartIndex(index);
+        }
+    }
+
+    // Set an integer uniform variable of the current program object
+    //   location: Location of the uniform variable
+    //   x       : Value
+    static void uniform1i(GLint location, GLint x) {
+        if (change(location, &x, sizeof x)) {
+            glUniform1i(location, x);
+        }
+    }
+
+    // Set an integer vector uniform variable of the current program object
+    //   location: Location of the uniform variable
+    //   x, y    : Value
+    static void uniform2i(GLint location, GLint x, GLint y) {
+        const GLint value[] = {x, y};
+        if (change(location, value, sizeof value)) {
+            glUniform2i(location, x, y);
+        }
+    }
+
+    // Set a 3x3 matrix uniform variable of the current program object
+    //   location: Location of the uniform variable
+    //   value   : Elements of the matrix in column-major order
+    static void uniformMatrix3fv(GLint location, const GLfloat *value) {
+        if (change(location, value, 9 * sizeof(GLfloat))) {
+            glUniformMatrix3fv(location, 1, GL_FALSE, value);
+        }
+    }
+
+    // Set a 4x4 matrix uniform variable of the current program object
+    //   location: Location of the uniform variable
+    //   value   : Elements of the matrix in column-major order
+    static void uniformMatrix4fv(GLint location, const GLfloat *value) {
+        if (change(location, value, 16 * sizeof(GLfloat))) {
+            glUniformMatrix4fv(location, 1, GL_FALSE, value);
+        }
+    }
+
+    // Delete buffer objects, which are unbound from the targets they are bound to
+    //   n     : Number of buffer objects
+    //   buffer: Buffer object names
+    static void deleteBuffers(GLsizei n, const GLuint *buffer) {
+        State &s(state());
+        for (auto &b : s.buffers) {
+            if (std::find(buffer, buffer + n, b.second) != buffer + n) {
+                b.second = 0;
+            }
+        }
+        for (auto &b : s.indexedBuffers) {
+            if (std::find(buffer, buffer + n, b.second) != buffer + n) {
+                b.second = 0;
+            }
+        }
+        glDeleteBuffers(n, buffer);
+    }
+
+    // Delete a vertex array object, which is unbound if it is bound
+    //   vao: Vertex array object name
+    static void deleteVertexArray(GLuint vao) {
+        State &s(state());
+        if (s.vertexArray == vao) {
+            s.vertexArray = 0;
+        }
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    // Delete a program object and forget its uniform variables, whose name may be used again
+    //   program: Program object name
+    static void deleteProgram(GLuint program) {
+        State &s(state());
+        std::erase_if(s.uniforms, [&](const auto &u) { return u.first >> 32 == program; });
+        if (s.program == program) {
+            s.program = unknown;
+        }
+        glDeleteProgram(program);
+    }
+
+    // End a frame
+    //   Returns the numbers of calls since the end of the previous frame
+    static Counters endFrame() {
+        const Counters counters(state().counters);
+        state().counters = Counters{};
+        return counters;
+    }
+};
@@ -0,0 +1,240 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Measurement of the GPU time of named drawing passes
+//   Each pass is enclosed in a GL_TIME_ELAPSED query taken from a ring several frames deep,
+//   and the results are read back only when they are available, so the pipeline never stalls
+class GpuTimer {
+    // Measurement results of a pass
+    struct Pass {
+        // Name of the pass
+        std::string name;
+        // Recent samples in milliseconds, oldest first
+        std::deque<double> samples;
+    };
+
+    // Queries issued in one frame
+    struct Frame {
+        // Number of the frame
+        long number{};
+        // Query objects, reused every time the frame comes around the ring
+        std::vector<GLuint> queries;
+        // Index of the pass measured by each query
+        std::vector<std::size_t> passes;
+        // Number of queries issued in this frame
+        std::size_t used{};
+    };
+
+    // Whether timer queries are supported and measurement is requested
+    bool enabled;
+    // Number of samples kept per pass
+    std::size_t window;
+    // Measured passes
+    std::vector<Pass> passes;
+    // Ring of frames waiting for the results
+    std::vector<Frame> ring;
+    // Number of the current frame
+    long frame{-1};
+    // Whether a query is active
+    bool active{};
+    // Number of frames whose results were dropped because they were not available in time
+    long dropped{};
+    // Output destination of the samples in CSV format
+    std::ostream *csv{};
+
+  public:
+    // Statistics of a pass in milliseconds
+    struct Stats {
+        double min, avg, p99;
+        std::size_t count;
+    };
+
+    // Constructor
+    //   enable: Whether to measure
+    //   depth : Number of frames in the ring, i.e. the latency of the results
+    //   window: Number of samples per pass used in the statistics
+    explicit GpuTimer(bool enable = true, int depth = 4, std::size_t window = 240)
+        : enabled(enable && (GLEW_VERSION_3_3 || GLEW_ARB_timer_query)), window(window), ring(depth) {}
+
+    // Destructor
+    virtual ~GpuTimer() {
+        for (Frame &f : ring) {
+            if (!f.queries.empty()) {
+                glDeleteQueries(static_cast<GLsizei>(f.queries.size()), f.queries.data());
+            }
+        }
+    }
+
+    // Copy prohibition
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    // Whether measuring
+    explicit operator bool() const { return enabled; }
+
+    // Write the samples to a stream in CSV format
+    //   os: Output stream, nullptr to stop writing
+    void setCsv(std::ostream *os) {
+        csv = os;
+        if (csv != nullptr) {
+            *csv << "frame,pass,milliseconds\n";
+        }
+    }
+
+    // Start a new frame
+    //   Collects the results of the frame that occupied the slot of the ring
+    void beginFrame() {
+        if (!enabled) {
+            return;
+        }
+
+        // Discard the results of the frame in the slot to be reused if they are still not available
+        ++frame;
+        Frame &f(ring[frame % ring.size()]);
+        collect(f, true);
+
+        // Results of the newer frames may also be available by now
+        for (long n = std::max(frame - static_cast<long>(ring.size()) + 1, 0L); n < frame; ++n) {
+            collect(ring[n % ring.size()], false);
+        }
+
+        f.number = frame;
+        f.used = 0;
+        f.passes.clear();
+    }
+
+    // Wait for the frames still in the ring and collect their results
+    //   Called once after the last frame, since it stalls the pipeline
+    void finish() {
+        if (!enabled || frame < 0) {
+            return;
+        }
+        end();
+        glFinish();
+        for (long n = std::max(frame - static_cast<long>(ring.size()) + 1, 0L); n <= frame; ++n) {
+            collect(ring[n % ring.size()], false);
+        }
+    }
+
+    // Start measuring a pass
+    //   Passes cannot be nested
+    //   name: Name of the pass
+    void begin(const char *name) {
+        if (!enabled || frame < 0 || active) {
+            return;
+        }
+
+        // Find the pass by name
+        std::size_t pass(0);
+        while (pass < passes.size() && passes[pass].name != name) {
+            ++pass;
+        }
+        if (pass == passes.size()) {
+            passes.push_back({name, {}});
+        }
+
+        // Take a query object of this frame
+        Frame &f(ring[frame % ring.size()]);
+        if (f.used == f.queries.size()) {
+            GLuint query;
+            glGenQueries(1, &query);
+            f.queries.push_back(query);
+        }
+        f.passes.push_back(pass);
+        glBeginQuery(GL_TIME_ELAPSED, f.queries[f.used++]);
+        active = true;
+    }
+
+    // End measuring the pass
+    void end() {
+        if (active) {
+            glEndQuery(GL_TIME_ELAPSED);
+            active = false;
+        }
+    }
+
+    // Retrieve the statistics of a pass
+    //   name: Name of the pass
+    [[nodiscard]] Stats getStats(const char *name) const {
+        for (const Pass &p : passes) {
+            if (p.name == name) {
+                return stats(p);
+            }
+        }
+        return {0.0, 0.0, 0.0, 0};
+    }
+
+    // Print the statistics of all passes
+    //   os: Output stream
+    void report(std::ostream &os) const {
+        for (const Pass &p : passes) {
+            const Stats s(stats(p));
+            os << p.name << ": min " << s.min << " ms, avg " << s.avg << " ms, p99 " << s.p99 << " ms (" << s.count
+               << " samples)\n";
+        }
+        if (dropped > 0) {
+            os << dropped << " frames dropped" << '\n';
+        }
+    }
+
+  private:
+    // Read back the results of a frame
+    //   f      : Frame in the ring
+    //   discard: Whether to give up the results if they are not available yet
+    void collect(Frame &f, bool discard) {
+        if (f.used == 0) {
+            return;
+        }
+
+        // Queries complete in order, so the last one tells if all of them are available
+        GLint available;
+        glGetQueryObjectiv(f.queries[f.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) {
+            if (discard) {
+                ++dropped;
+                f.used = 0;
+            }
+            return;
+        }
+
+        for (std::size_t i = 0; i < f.used; ++i) {
+            GLuint64 elapsed;
+            glGetQueryObjectui64v(f.queries[i], GL_QUERY_RESULT, &elapsed);
+            const double ms(static_cast<double>(elapsed) * 1.0e-6);
+
+            // Keep the samples of the window
+            Pass &p(passes[f.passes[i]]);
+            p.samples.push_back(ms);
+            if (p.samples.size() > window) {
+                p.samples.pop_front();
+            }
+
+            if (csv != nullptr) {
+                *csv << f.number << ',' << p.name << ',' << ms << '\n';
+            }
+        }
+        f.used = 0;
+    }
+
+    // Calculate the statistics of the samples of a pass
+    //   p: Pass
+    static Stats stats(const Pass &p) {
+        if (p.samples.empty()) {
+            return {0.0, 0.0, 0.0, 0};
+        }
+
+        std::vector<double> s(p.samples.begin(), p.samples.end());
+        std::sort(s.begin(), s.end());
+        double sum(0.0);
+        for (const double v : s) {
+            sum += v;
+        }
+        const std::size_t n(s.size());
+        return {s.front(), sum / static_cast<double>(n), s[std::min(n - 1, n * 99 / 100)], n};
+    }
+};
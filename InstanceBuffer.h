@@ -0,0 +1,93 @@
+#pragma once
+#include <GL/glew.h>
+
+// Cache of the OpenGL state
+#include "GlState.h"
+
+// Per-instance attributes for instanced drawing
+class InstanceBuffer {
+    // Vertex buffer object name
+    GLuint vbo{};
+
+    // Number of instances the buffer object can hold
+    GLsizei capacity{};
+
+    // Number of instances stored
+    GLsizei count{};
+
+  public:
+    // Instance attribute
+    struct Instance {
+        // Model view transformation matrix
+        GLfloat modelview[16];
+
+        // Transformation matrix of the normal vector
+        GLfloat normalMatrix[9];
+    };
+
+    // Attribute locations, a mat4 takes four locations and a mat3 takes three
+    static constexpr GLuint modelviewLocation = 2;
+    static constexpr GLuint normalMatrixLocation = 6;
+
+    // Constructor
+    //   capacity: Initial number of instances
+    explicit InstanceBuffer(GLsizei capacity = 0) {
+        glGenBuffers(1, &vbo);
+        reserve(capacity);
+    }
+
+    // Destructor
+    virtual ~InstanceBuffer() { GlState::deleteBuffers(1, &vbo); }
+
+    // Copy prohibition
+    InstanceBuffer(const InstanceBuffer &) = delete;
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+    // Number of instances stored
+    [[nodiscard]] GLsizei size() const { return count; }
+
+    // Extend the buffer object to hold the given number of instances
+    //   n: Number of instances
+    void reserve(GLsizei n) {
+        if (n > capacity) {
+            capacity = n;
+            GlState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    // Replace the instances
+    //   instance: Array containing the instance attributes
+    //   n       : Number of instances
+    void update(const Instance *instance, GLsizei n) {
+        count = n;
+        GlState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (n > capacity) {
+            capacity = n;
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), instance, GL_STREAM_DRAW);
+        } else {
+            // Orphan the storage still used by the previous drawing before writing
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, n * sizeof(Instance), instance);
+        }
+    }
+
+    // Point the per-instance attributes of the bound vertex array object at this buffer object
+    void attach() const {
+        GlState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+        for (GLuint i = 0; i < 4; ++i) {
+            const GLuint location(modelviewLocation + i);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  static_cast<Instance *>(nullptr)->modelview + 4 * i);
+            glVertexAttribDivisor(location, 1);
+            glEnableVertexAttribArray(location);
+        }
+        for (GLuint i = 0; i < 3; ++i) {
+            const GLuint location(normalMatrixLocation + i);
+            glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  static_cast<Instance *>(nullptr)->normalMatrix + 3 * i);
+            glVertexAttribDivisor(location, 1);
+            glEnableVertexAttribArray(location);
+        }
+    }
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Pool of worker threads that steal jobs from each other
+//   Every thread has its own queue, takes the newest job of it, and steals the oldest job of another queue when its
+//   own is empty, so the threads mostly touch their own queue and large pieces of work are stolen first. The threads
+//   outside the pool share one queue. A thread waiting for its jobs runs jobs meanwhile, so a job may wait for other
+//   jobs without blocking a worker
+class JobSystem {
+    // Queue of jobs of a thread
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    // Queues, the first one for the threads outside the pool and the rest for the workers
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    // Worker threads
+    std::vector<std::thread> workers;
+
+    // Number of jobs queued but not taken yet
+    std::atomic<std::size_t> queued{0};
+
+    // Whether the workers keep running
+    bool running{true};
+
+    // Sleep of the workers while there are no jobs
+    std::mutex sleep;
+    std::condition_variable wake;
+
+    // Pool and queue of the calling thread
+    struct Worker {
+        const JobSystem *pool;
+        std::size_t index;
+    };
+    static Worker &current() {
+        thread_local Worker worker{nullptr, 0};
+        return worker;
+    }
+
+    // Queue of the calling thread, the shared one outside this pool
+    [[nodiscard]] std::size_t self() const { return current().pool == this ? current().index : 0; }
+
+  public:
+    // Constructor
+    //   threads: Number of threads running the jobs including the caller, 0 to use every hardware thread
+    explicit JobSystem(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        for (unsigned i = 0; i < threads; ++i) {
+            queues.emplace_back(new Queue);
+        }
+        for (std::size_t i = 1; i < threads; ++i) {
+            workers.emplace_back([this, i] {
+                current() = {this, i};
+                work();
+            });
+        }
+    }
+
+    // Destructor
+    virtual ~JobSystem() {
+        {
+            const std::lock_guard<std::mutex> lock(sleep);
+            running = false;
+        }
+        wake.notify_all();
+        for (std::thread &t : workers) {
+            t.join();
+        }
+    }
+
+    // Copy prohibition
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Number of threads running the jobs including the caller
+    [[nodiscard]] unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Run a function over a range of indices split into pieces and wait for all of them
+    //   count: Number of indices
+    //   grain: Smallest number of indices in a piece
+    //   f    : Function called with the first index and the index after the last one of each piece
+    template <typename F>
+    void parallelFor(std::size_t count, std::size_t grain, F &&f) {
+        // Enough pieces for every thread to steal a few, but none smaller than the grain
+        const std::size_t piece(std::max({grain, std::size_t(1), (count + 4 * size() - 1) / (4 * size())}));
+        if (count <= piece || size() == 1) {
+            if (count > 0) {
+                f(std::size_t(0), count);
+            }
+            return;
+        }
+
+        // Queue all pieces but the first one, which the caller runs at once
+        std::atomic<std::size_t> remaining((count + piece - 1) / piece - 1);
+        {
+            Queue &q(*queues[self()]);
+            const std::lock_guard<std::mutex> lock(q.mutex);
+            for (std::size_t begin = piece; begin < count; begin += piece) {
+                const std::size_t end(std::min(begin + piece, count));
+                q.jobs.emplace_back([&f, &remaining, begin, end] {
+                    f(begin, end);
+                    remaining.fetch_sub(1, std::memory_order_release);
+                });
+            }
+            queued.fetch_add(remaining.load(std::memory_order_relaxed), std::memory_order_release);
+        }
+        {
+            // Pass through the lock so that a worker about to sleep sees the jobs before the notification
+            const std::lock_guard<std::mutex> lock(sleep);
+        }
+        wake.notify_all();
+        f(std::size_t(0), piece);
+
+        // Help with any jobs until the pieces are done
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (!runOne()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+  private:
+    // Take a job from the own queue, or else steal one from another queue
+    //   job: Storage location of the job taken
+    //   Returns false if every queue is empty
+    bool take(std::function<void()> &job) {
+        const std::size_t own(self());
+        {
+            Queue &q(*queues[own]);
+            const std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.jobs.empty()) {
+                job = std::move(q.jobs.back());
+                q.jobs.pop_back();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // Try the other queues from a random one
+        thread_local std::minstd_rand rng(static_cast<unsigned>(own) + 1u);
+        const std::size_t n(queues.size()), start(rng() % n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::size_t victim((start + i) % n);
+            if (victim == own) {
+                continue;
+            }
+            Queue &q(*queues[victim]);
+            const std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.jobs.empty()) {
+                job = std::move(q.jobs.front());
+                q.jobs.pop_front();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Run a job if there is one
+    //   Returns false if there was no job
+    bool runOne() {
+        std::function<void()> job;
+        if (!take(job)) {
+            return false;
+        }
+        job();
+        return true;
+    }
+
+    // Loop of a worker
+    void work() {
+        for (;;) {
+            if (runOne()) {
+                continue;
+            }
+
+            // Sleep until jobs are queued or the pool is destroyed
+            std::unique_lock<std::mutex> lock(sleep);
+            wake.wait(lock, [this] { return !running || queued.load(std::memory_order_acquire) > 0; });
+            if (!running) {
+                return;
+            }
+        }
+    }
+};
@@ -0,0 +1,223 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Cache of the OpenGL state
+#include "GlState.h"
+
+// Transformation matrix
+#include "Matrix.h"
+
+// Uniform buffer object
+#include "UniformBuffer.h"
+
+// Point light source
+struct PointLight {
+    // Position in the eye coordinate system and radius of influence
+    GLfloat position[3], radius;
+
+    // Diffuse and specular intensity, the fourth element is not used
+    GLfloat color[4];
+};
+
+// Clustered light assignment for per-fragment lighting
+//   Lights are binned on the CPU into clusters that split the view frustum into tiles on the screen and exponential
+//   slices in depth, and the light lists are stored in texture buffers so that each fragment only visits the lights
+//   that can reach its cluster
+class LightCluster {
+    // Contents of the uniform block Cluster in the std140 layout
+    struct Grid {
+        // Number of clusters in x, y and z, the fourth element is not used
+        GLint count[4];
+
+        // Clusters per pixel in x and y, scale and bias of the slice from the log of the depth
+        GLfloat scale[4];
+    };
+
+    // Number of clusters in x, y and z
+    const int nx, ny, nz;
+
+    // Uniform buffer object of the grid parameters
+    UniformBuffer<Grid> grid;
+
+    // First texture unit used, the light lists take three from here
+    const GLint unit;
+
+    // Buffer objects and texture buffers of the clusters, the light indices and the lights
+    GLuint buffer[3]{};
+    GLuint texture[3]{};
+
+    // Lights in the eye coordinate system
+    std::vector<PointLight> lights;
+
+    // Cluster range covered by each light, empty when x0 > x1
+    struct Range {
+        int x0, x1, y0, y1, z0, z1;
+    };
+    std::vector<Range> ranges;
+
+    // Offset and count of the light indices of each cluster
+    std::vector<GLuint> clusters;
+
+    // Light indices of all clusters
+    std::vector<GLuint> indices;
+
+  public:
+    // Constructor
+    //   x, y, z: Number of clusters in each direction
+    //   binding: Binding point of the uniform block Cluster
+    //   unit   : First of the three texture units used for the light lists
+    LightCluster(int x, int y, int z, GLuint binding, GLint unit)
+        : nx(x), ny(y), nz(z), grid(binding), unit(unit), clusters(2 * x * y * z) {
+        // Texture buffers of the clusters (offset and count), the light indices and the lights (two texels each)
+        static constexpr GLenum format[] = {GL_RG32UI, GL_R32UI, GL_RGBA32F};
+        glGenBuffers(3, buffer);
+        glGenTextures(3, texture);
+        for (int i = 0; i < 3; ++i) {
+            GlState::bindBuffer(GL_TEXTURE_BUFFER, buffer[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+            glActiveTexture(GL_TEXTURE0 + unit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, texture[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, format[i], buffer[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Destructor
+    virtual ~LightCluster() {
+        glDeleteTextures(3, texture);
+        GlState::deleteBuffers(3, buffer);
+    }
+
+    // Copy prohibition
+    LightCluster(const LightCluster &) = delete;
+    LightCluster &operator=(const LightCluster &) = delete;
+
+    // Connect a program object to the light lists
+    //   The program object becomes the current one
+    //   program: Program object name using the uniform block Cluster and the samplers clusters, indices and lights
+    void bind(GLuint program) const {
+        grid.bind(program, "Cluster");
+        GlState::useProgram(program);
+        GlState::uniform1i(glGetUniformLocation(program, "clusters"), unit);
+        GlState::uniform1i(glGetUniformLocation(program, "indices"), unit + 1);
+        GlState::uniform1i(glGetUniformLocation(program, "lights"), unit + 2);
+    }
+
+    // Replace the lights
+    //   light: Array of lights in the eye coordinate system
+    //   count: Number of lights
+    void setLights(const PointLight *light, std::size_t count) {
+        lights.assign(light, light + count);
+        GlState::bindBuffer(GL_TEXTURE_BUFFER, buffer[2]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<GLsizeiptr>(count * sizeof(PointLight), 16), lights.data(),
+                     GL_STREAM_DRAW);
+    }
+
+    // Number of light indices stored in all clusters
+    [[nodiscard]] std::size_t size() const { return indices.size(); }
+
+    // Assign the lights to the clusters
+    //   projection: Perspective projection transformation matrix
+    //   width     : Width of the viewport
+    //   height    : Height of the viewport
+    void update(const Matrix &projection, GLfloat width, GLfloat height) {
+        // Parameters of the perspective projection
+        const GLfloat px(projection[0]), py(projection[5]);
+        const GLfloat zNear(projection[14] / (projection[10] - 1.0f));
+        const GLfloat zFar(projection[14] / (projection[10] + 1.0f));
+
+        // Slices are spaced exponentially in depth
+        const GLfloat zScale(static_cast<GLfloat>(nz) / std::log(zFar / zNear));
+        const GLfloat zBias(-std::log(zNear) * zScale);
+        const auto slice([&](GLfloat depth) {
+            return std::clamp(static_cast<int>(std::log(depth) * zScale + zBias), 0, nz - 1);
+        });
+
+        // Tile of a coordinate in the normalized device coordinate system
+        const auto tile([](GLfloat ndc, int n) {
+            return std::clamp(static_cast<int>((ndc * 0.5f + 0.5f) * static_cast<GLfloat>(n)), 0, n - 1);
+        });
+
+        // Count the lights of each cluster
+        std::vector<GLuint> count(nx * ny * nz, 0);
+        ranges.resize(lights.size());
+        for (std::size_t i = 0; i < lights.size(); ++i) {
+            const PointLight &l(lights[i]);
+            Range &r(ranges[i]);
+
+            // Range of the depth, the eye looks down the negative z axis
+            const GLfloat d0(-l.position[2] - l.radius), d1(-l.position[2] + l.radius);
+            if (d1 < zNear || d0 > zFar) {
+                r = {0, -1, 0, -1, 0, -1};
+                continue;
+            }
+            r.z0 = slice(std::max(d0, zNear));
+            r.z1 = slice(std::min(d1, zFar));
+
+            if (d0 < zNear) {
+                // The bounding box crosses the near plane, so its projection may cover the whole screen
+                r.x0 = r.y0 = 0;
+                r.x1 = nx - 1;
+                r.y1 = ny - 1;
+            } else {
+                // Project the bounding box, the extremes are at the nearest or the farthest depth
+                const GLfloat x0(l.position[0] - l.radius), x1(l.position[0] + l.radius);
+                const GLfloat y0(l.position[1] - l.radius), y1(l.position[1] + l.radius);
+                const GLfloat sx0(std::min(x0 / d0, x0 / d1) * px), sx1(std::max(x1 / d0, x1 / d1) * px);
+                const GLfloat sy0(std::min(y0 / d0, y0 / d1) * py), sy1(std::max(y1 / d0, y1 / d1) * py);
+                if (sx0 > 1.0f || sx1 < -1.0f || sy0 > 1.0f || sy1 < -1.0f) {
+                    r = {0, -1, 0, -1, 0, -1};
+                    continue;
+                }
+                r.x0 = tile(sx0, nx);
+                r.x1 = tile(sx1, nx);
+                r.y0 = tile(sy0, ny);
+                r.y1 = tile(sy1, ny);
+            }
+
+            for (int z = r.z0; z <= r.z1; ++z) {
+                for (int y = r.y0; y <= r.y1; ++y) {
+                    for (int x = r.x0; x <= r.x1; ++x) {
+                        ++count[(z * ny + y) * nx + x];
+                    }
+                }
+            }
+        }
+
+        // Offset of the light indices of each cluster
+        GLuint offset(0);
+        for (std::size_t c = 0; c < count.size(); ++c) {
+            clusters[2 * c] = offset;
+            clusters[2 * c + 1] = 0;
+            offset += count[c];
+        }
+
+        // Store the light indices
+        indices.resize(offset);
+        for (std::size_t i = 0; i < lights.size(); ++i) {
+            const Range &r(ranges[i]);
+            for (int z = r.z0; z <= r.z1; ++z) {
+                for (int y = r.y0; y <= r.y1; ++y) {
+                    for (int x = r.x0; x <= r.x1; ++x) {
+                        GLuint *const c(&clusters[2 * ((z * ny + y) * nx + x)]);
+                        indices[c[0] + c[1]++] = static_cast<GLuint>(i);
+                    }
+                }
+            }
+        }
+
+        // Send the light lists
+        GlState::bindBuffer(GL_TEXTURE_BUFFER, buffer[0]);
+        glBufferData(GL_TEXTURE_BUFFER, clusters.size() * sizeof(GLuint), clusters.data(), GL_STREAM_DRAW);
+        GlState::bindBuffer(GL_TEXTURE_BUFFER, buffer[1]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<GLsizeiptr>(indices.size() * sizeof(GLuint), 16), indices.data(),
+                     GL_STREAM_DRAW);
+
+        // Send the grid parameters only when they have changed
+        grid.set({{nx, ny, nz, 0},
+                  {static_cast<GLfloat>(nx) / width, static_cast<GLfloat>(ny) / height, zScale, zBias}});
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Drawing shapes
+#include "Shape.h"
+
+// Transformation matrix
+#include "Matrix.h"
+
+// Shape with several tessellations chosen by the size on the screen
+//   The levels go from the finest to the coarsest, and each one is used down to a projected radius in pixels. The
+//   selection keeps the previous level of each drawn object until the radius moves past the threshold by a margin, so
+//   an object near a threshold does not flicker between two levels
+class LodShape {
+    // Level of detail
+    struct Level {
+        // Tessellation
+        std::unique_ptr<const Shape> shape;
+        // Smallest projected radius in pixels drawn with this level
+        GLfloat radius;
+        // Number of triangles
+        std::size_t triangles;
+    };
+
+    // Levels from the finest
+    std::vector<Level> levels;
+
+    // Relative margin around the thresholds
+    const GLfloat hysteresis;
+
+  public:
+    // Constructor
+    //   hysteresis: Relative margin the projected radius must pass a threshold by to change the level
+    explicit LodShape(GLfloat hysteresis = 0.2f) : hysteresis(hysteresis) {}
+
+    // Destructor
+    virtual ~LodShape() = default;
+
+    // Copy prohibition
+    LodShape(const LodShape &) = delete;
+    LodShape &operator=(const LodShape &) = delete;
+
+    // Add a level coarser than the ones already added
+    //   shape    : Tessellation
+    //   radius   : Smallest projected radius in pixels drawn with this level, the last level is drawn down to 0
+    //   triangles: Number of triangles of the tessellation
+    void addLevel(const Shape *shape, GLfloat radius, std::size_t triangles) {
+        levels.push_back({std::unique_ptr<const Shape>(shape), radius, triangles});
+    }
+
+    // Number of levels
+    [[nodiscard]] int size() const { return static_cast<int>(levels.size()); }
+
+    // Tessellation of a level
+    //   level: Level from select()
+    [[nodiscard]] const Shape &operator[](int level) const { return *levels[level].shape; }
+
+    // Number of triangles of a level
+    //   level: Level from select()
+    [[nodiscard]] std::size_t getTriangleCount(int level) const { return levels[level].triangles; }
+
+    // Select the level of an object
+    //   pixels : Projected radius of the object in pixels
+    //   current: Level of the object in the previous frame, negative if it was not drawn
+    [[nodiscard]] int select(GLfloat pixels, int current) const {
+        const int last(size() - 1);
+        if (current < 0 || current > last) {
+            // Without history, take the finest level the radius reaches
+            int level(0);
+            while (level < last && pixels < levels[level].radius) {
+                ++level;
+            }
+            return level;
+        }
+
+        // Change to a finer level only when clearly above its threshold, and to a coarser one when clearly below
+        int level(current);
+        while (level > 0 && pixels >= levels[level - 1].radius * (1.0f + hysteresis)) {
+            --level;
+        }
+        while (level < last && pixels < levels[level].radius * (1.0f - hysteresis)) {
+            ++level;
+        }
+        return level;
+    }
+
+    // Projected radius in pixels of a bounding sphere
+    //   projection: Perspective projection transformation matrix
+    //   modelview : Model view transformation matrix of the object
+    //   radius    : Radius of the bounding sphere around the origin of the object
+    //   height    : Height of the viewport in pixels
+    //   Returns infinity if the viewpoint is inside the sphere
+    template <typename Kind>
+    static GLfloat projectedRadius(const Matrix &projection, const BasicMatrix<Kind> &modelview, GLfloat radius,
+                                   GLfloat height) {
+        // Largest scale of the model view transformation
+        GLfloat scale(0.0f);
+        for (int i = 0; i < 3; ++i) {
+            const GLfloat *const c(modelview.data() + 4 * i);
+            scale = std::max(scale, c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+        }
+        const GLfloat r(radius * std::sqrt(scale));
+
+        // Distance of the center in front of the viewpoint
+        const GLfloat distance(-modelview[14]);
+        if (distance <= r) {
+            return std::numeric_limits<GLfloat>::infinity();
+        }
+
+        // projection[5] is the cotangent of half the field of view
+        return r * projection[5] * 0.5f * height / distance;
+    }
+};
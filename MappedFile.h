@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Contents of a file mapped read-only into memory
+//   Where files are not mapped, the contents are read into memory instead
+class MappedFile {
+    // Mapped contents of the file
+    const unsigned char *contents{};
+    std::size_t length{};
+
+#if defined(_WIN32)
+    // Contents read into memory where the file is not mapped
+    std::vector<unsigned char> buffer;
+#endif
+
+  public:
+    // Constructor
+    //   path: File name
+    explicit MappedFile(const char *path) {
+#if defined(_WIN32)
+        std::ifstream file(path, std::ios::binary);
+        if (file) {
+            buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            contents = buffer.data();
+            length = buffer.size();
+        }
+#else
+        const int fd(open(path, O_RDONLY));
+        struct stat st {};
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *const p(mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0));
+            if (p != MAP_FAILED) {
+                contents = static_cast<const unsigned char *>(p);
+                length = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    // Destructor
+    virtual ~MappedFile() {
+#if !defined(_WIN32)
+        if (contents != nullptr) {
+            munmap(const_cast<unsigned char *>(contents), length);
+        }
+#endif
+    }
+
+    // Copy prohibition
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Whether the file was mapped and is not empty
+    explicit operator bool() const { return contents != nullptr; }
+
+    // Contents of the file
+    [[nodiscard]] const unsigned char *data() const { return contents; }
+
+    // Size of the file in bytes
+    [[nodiscard]] std::size_t size() const { return length; }
+
+    // Tell that a range of the contents is read once from the beginning to the end
+    //   begin: Byte offset of the range
+    //   end  : Byte offset after the range
+    void sequential(std::size_t begin, std::size_t end) const { advise(begin, end, true); }
+
+    // Release the pages of a range of the contents that has been read, which are read again from the file if needed
+    //   begin: Byte offset of the range
+    //   end  : Byte offset after the range
+    void release(std::size_t begin, std::size_t end) const { advise(begin, end, false); }
+
+  private:
+    // Give advice on the use of the pages in a range of the contents
+    //   begin: Byte offset of the range
+    //   end  : Byte offset after the range
+    //   ahead: Whether the range is read ahead, or else the pages are dropped
+    void advise(std::size_t begin, std::size_t end, bool ahead) const {
+#if !defined(_WIN32)
+        // Whole pages inside the range
+        const std::size_t page(static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+        begin = (begin + page - 1) / page * page;
+        end = std::min(end, length) / page * page;
+        if (contents != nullptr && begin < end) {
+            madvise(const_cast<unsigned char *>(contents) + begin, end - begin,
+                    ahead ? MADV_SEQUENTIAL : MADV_DONTNEED);
+        }
+#endif
+    }
+};
@@ -1,57 +1,164 @@
 #pragma once
+#include "Simd.h"
 #include <GL/glew.h>
 #include <algorithm>
 #include <cmath>
+#include <type_traits>
+
+// Kinds of transformation matrix, from the most general to the most restricted
+//   Projective: Any 4x4 matrix
+//   Affine    : The bottom row is (0, 0, 0, 1)
+//   Rigid     : Affine, and the upper left 3x3 is a rotation
+struct Projective {
+    static constexpr int level = 0;
+};
+struct Affine {
+    static constexpr int level = 1;
+};
+struct Rigid {
+    static constexpr int level = 2;
+};
 
-// Transformation matrix
-class Matrix {
-    GLfloat matrix[16]{};
+// The kind of the composition of two kinds of transformation
+template <typename A, typename B>
+using CommonKind = std::conditional_t<(A::level < B::level), A, B>;
+
+// Transformation matrix of the given kind
+//   The kind only selects cheaper kernels, so it must be kept true when writing elements
+template <typename Kind>
+class BasicMatrix {
+    // Elements in column-major order, aligned for the SIMD kernels
+    alignas(16) GLfloat matrix[16]{};
+
+    // Allow access to the elements of the other kinds
+    template <typename>
+    friend class BasicMatrix;
 
   public:
-    Matrix() = default;
+    constexpr BasicMatrix() = default;
 
     // Constructor initialized with the contents of an array
     //  a: 16-element array of GLfloat type
-    explicit Matrix(const GLfloat *a) { std::copy(a, a + 16, matrix); }
+    constexpr explicit BasicMatrix(const GLfloat *a) { std::copy(a, a + 16, matrix); }
+
+    // Conversion from another kind
+    //   Widening to a more general kind is implicit, narrowing must be explicit
+    template <typename K>
+    constexpr explicit(K::level < Kind::level) BasicMatrix(const BasicMatrix<K> &m) {
+        std::copy(m.matrix, m.matrix + 16, matrix);
+    }
 
     // Referring to an element of a matrix as the right-hand side value
-    const GLfloat &operator[](std::size_t i) const { return matrix[i]; }
+    constexpr const GLfloat &operator[](std::size_t i) const { return matrix[i]; }
 
     // Referring to an element of a matrix as the left-hand side value
-    GLfloat &operator[](std::size_t i) { return matrix[i]; }
+    constexpr GLfloat &operator[](std::size_t i) { return matrix[i]; }
 
     // Returns an array of transformation matrices
-    [[nodiscard]] const GLfloat *data() const { return matrix; }
+    [[nodiscard]] constexpr const GLfloat *data() const { return matrix; }
 
     // Calculate the transformation matrix of the normal vector
-    void getNormalMatrix(GLfloat *m) const {
-        m[0] = matrix[5] * matrix[10] - matrix[6] * matrix[9];
-        m[1] = matrix[6] * matrix[8] - matrix[4] * matrix[10];
-        m[2] = matrix[4] * matrix[9] - matrix[5] * matrix[8];
-        m[3] = matrix[9] * matrix[2] - matrix[10] * matrix[1];
-        m[4] = matrix[10] * matrix[0] - matrix[8] * matrix[2];
-        m[5] = matrix[8] * matrix[1] - matrix[9] * matrix[0];
-        m[6] = matrix[1] * matrix[6] - matrix[2] * matrix[5];
-        m[7] = matrix[2] * matrix[4] - matrix[0] * matrix[6];
-        m[8] = matrix[0] * matrix[5] - matrix[1] * matrix[4];
+    constexpr void getNormalMatrix(GLfloat *m) const {
+        if constexpr (std::is_same_v<Kind, Rigid>) {
+            // The cofactor matrix of a rotation is the rotation itself
+            m[0] = matrix[0];
+            m[1] = matrix[1];
+            m[2] = matrix[2];
+            m[3] = matrix[4];
+            m[4] = matrix[5];
+            m[5] = matrix[6];
+            m[6] = matrix[8];
+            m[7] = matrix[9];
+            m[8] = matrix[10];
+        } else {
+            m[0] = matrix[5] * matrix[10] - matrix[6] * matrix[9];
+            m[1] = matrix[6] * matrix[8] - matrix[4] * matrix[10];
+            m[2] = matrix[4] * matrix[9] - matrix[5] * matrix[8];
+            m[3] = matrix[9] * matrix[2] - matrix[10] * matrix[1];
+            m[4] = matrix[10] * matrix[0] - matrix[8] * matrix[2];
+            m[5] = matrix[8] * matrix[1] - matrix[9] * matrix[0];
+            m[6] = matrix[1] * matrix[6] - matrix[2] * matrix[5];
+            m[7] = matrix[2] * matrix[4] - matrix[0] * matrix[6];
+            m[8] = matrix[0] * matrix[5] - matrix[1] * matrix[4];
+        }
+    }
+
+    // Calculate the inverse matrix
+    //   The matrix must be invertible, and the inverse is of the same kind
+    [[nodiscard]] constexpr BasicMatrix inverse() const {
+        BasicMatrix t;
+        if constexpr (Kind::level > Projective::level) {
+            // Inverse of the upper left 3x3, the transpose for a rotation
+            if constexpr (std::is_same_v<Kind, Rigid>) {
+                for (int j = 0; j < 3; ++j) {
+                    for (int i = 0; i < 3; ++i) {
+                        t.matrix[j * 4 + i] = matrix[i * 4 + j];
+                    }
+                }
+            } else {
+                GLfloat c[9];
+                getNormalMatrix(c);
+                const GLfloat det(matrix[0] * c[0] + matrix[1] * c[1] + matrix[2] * c[2]);
+                for (int j = 0; j < 3; ++j) {
+                    for (int i = 0; i < 3; ++i) {
+                        t.matrix[j * 4 + i] = c[i * 3 + j] / det;
+                    }
+                }
+            }
+
+            // Translation moved back by the inverse
+            for (int i = 0; i < 3; ++i) {
+                t.matrix[12 + i] =
+                    -(t.matrix[i] * matrix[12] + t.matrix[4 + i] * matrix[13] + t.matrix[8 + i] * matrix[14]);
+            }
+            t.matrix[15] = 1.0f;
+        } else {
+            // Cofactors of the 2x2 minors of the upper and the lower halves
+            const GLfloat *const m(matrix);
+            const GLfloat s0(m[0] * m[5] - m[4] * m[1]), s1(m[0] * m[6] - m[4] * m[2]);
+            const GLfloat s2(m[0] * m[7] - m[4] * m[3]), s3(m[1] * m[6] - m[5] * m[2]);
+            const GLfloat s4(m[1] * m[7] - m[5] * m[3]), s5(m[2] * m[7] - m[6] * m[3]);
+            const GLfloat c5(m[10] * m[15] - m[14] * m[11]), c4(m[9] * m[15] - m[13] * m[11]);
+            const GLfloat c3(m[9] * m[14] - m[13] * m[10]), c2(m[8] * m[15] - m[12] * m[11]);
+            const GLfloat c1(m[8] * m[14] - m[12] * m[10]), c0(m[8] * m[13] - m[12] * m[9]);
+            const GLfloat r(1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0));
+
+            t.matrix[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * r;
+            t.matrix[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * r;
+            t.matrix[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * r;
+            t.matrix[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * r;
+            t.matrix[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * r;
+            t.matrix[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * r;
+            t.matrix[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * r;
+            t.matrix[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * r;
+            t.matrix[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * r;
+            t.matrix[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * r;
+            t.matrix[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * r;
+            t.matrix[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * r;
+            t.matrix[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * r;
+            t.matrix[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * r;
+            t.matrix[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * r;
+            t.matrix[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * r;
+        }
+        return t;
     }
 
     // Set the unit matrix
-    void loadIdentity() {
+    constexpr void loadIdentity() {
         std::fill(matrix, matrix + 16, 0.0f);
         matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0f;
     }
 
     // Create the unit matrix
-    static Matrix identity() {
-        Matrix t;
+    static constexpr BasicMatrix<Rigid> identity() {
+        BasicMatrix<Rigid> t;
         t.loadIdentity();
         return t;
     }
 
     // Create a transformation matrix that translates by (x, y, z)
-    static Matrix translate(GLfloat x, GLfloat y, GLfloat z) {
-        Matrix t;
+    static constexpr BasicMatrix<Rigid> translate(GLfloat x, GLfloat y, GLfloat z) {
+        BasicMatrix<Rigid> t;
         t.loadIdentity();
         t[12] = x;
         t[13] = y;
@@ -60,8 +167,8 @@ class Matrix {
     }
 
     // Create a transformation matrix that scales (x, y, z) times
-    static Matrix scale(GLfloat x, GLfloat y, GLfloat z) {
-        Matrix t;
+    static constexpr BasicMatrix<Affine> scale(GLfloat x, GLfloat y, GLfloat z) {
+        BasicMatrix<Affine> t;
         t.loadIdentity();
         t[0] = x;
         t[5] = y;
@@ -70,17 +177,18 @@ class Matrix {
     }
 
     // Create a transformation matrix with a rotation around (x, y, z)
-    static Matrix rotate(GLfloat a, GLfloat x, GLfloat y, GLfloat z) {
-        Matrix t;
-        const GLfloat d(sqrt(x * x + y * y + z * z));
+    //   Returns the unit matrix if the axis has no length
+    static constexpr BasicMatrix<Rigid> rotate(GLfloat a, GLfloat x, GLfloat y, GLfloat z) {
+        BasicMatrix<Rigid> t;
+        t.loadIdentity();
+        const GLfloat d(squareRoot(x * x + y * y + z * z));
 
         if (d > 0.0f) {
             const GLfloat l(x / d), m(y / d), n(z / d);
             const GLfloat l2(l * l), m2(m * m), n2(n * n);
             const GLfloat lm(l * m), mn(m * n), nl(n * l);
-            const GLfloat c(cos(a)), c1(1.0f - c), s(sin(a));
+            const GLfloat c(cosine(a)), c1(1.0f - c), s(sine(a));
 
-            t.loadIdentity();
             t[0] = (1.0f - l2) * c + l2;
             t[1] = lm * c1 + n * s;
             t[2] = nl * c1 - m * s;
@@ -96,12 +204,12 @@ class Matrix {
     }
 
     // Create view transformation matrix
-    static Matrix lookat(GLfloat ex, GLfloat ey, GLfloat ez, // Position of viewpoint
+    static constexpr BasicMatrix<Rigid> lookat(GLfloat ex, GLfloat ey, GLfloat ez, // Position of viewpoint
                          GLfloat gx, GLfloat gy, GLfloat gz, // Location of target point
                          GLfloat ux, GLfloat uy, GLfloat uz  // Upward vector
     ) {
         // Transformation matrix of translate
-        const Matrix tv(translate(-ex, -ey, -ez));
+        const BasicMatrix<Rigid> tv(translate(-ex, -ey, -ez));
 
         // Axis-t = e - g
         const GLfloat tx(ex - gx);
@@ -125,23 +233,23 @@ class Matrix {
         }
 
         // Transformation matrix of rotation
-        Matrix rv;
+        BasicMatrix<Rigid> rv;
         rv.loadIdentity();
 
         // r axis normalized and stored in array variable
-        const GLfloat r(sqrt(rx * rx + ry * ry + rz * rz));
+        const GLfloat r(squareRoot(rx * rx + ry * ry + rz * rz));
         rv[0] = rx / r;
         rv[4] = ry / r;
         rv[8] = rz / r;
 
         // s-axis normalized and stored in array variables
-        const GLfloat s(sqrt(s2));
+        const GLfloat s(squareRoot(s2));
         rv[1] = sx / s;
         rv[5] = sy / s;
         rv[9] = sz / s;
 
         // t-axis normalized and stored in array variables
-        const GLfloat t(sqrt(tx * tx + ty * ty + tz * tz));
+        const GLfloat t(squareRoot(tx * tx + ty * ty + tz * tz));
         rv[2] = tx / t;
         rv[6] = ty / t;
         rv[10] = tz / t;
@@ -152,25 +260,29 @@ class Matrix {
     }
 
     // Multiplication
-    Matrix operator*(const Matrix &m) const {
-        Matrix t;
-        for (int i = 0; i < 16; i++) {
-            const int j(i & 3), k(i & ~3);
-            t[i] = matrix[0 + j] * m[k + 0] + matrix[4 + j] * m[k + 1] + matrix[8 + j] * m[k + 2] +
-                   matrix[12 + j] * m[k + 3];
+    //   The result has the more general kind of the two operands
+    template <typename K>
+    constexpr BasicMatrix<CommonKind<Kind, K>> operator*(const BasicMatrix<K> &m) const {
+        BasicMatrix<CommonKind<Kind, K>> t;
+        if constexpr (std::is_same_v<CommonKind<Kind, K>, Projective>) {
+            multiply(matrix, m.matrix, t.matrix);
+        } else {
+            multiplyAffine(matrix, m.matrix, t.matrix);
         }
         return t;
     }
 
     // Create the orthogonal projection transformation matrix
-    static Matrix orthogonal(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat zNear, GLfloat zFar) {
-        Matrix t;
+    //   Returns the unit matrix if the volume has no extent in a direction
+    static constexpr BasicMatrix<Affine> orthogonal(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top,
+                                                     GLfloat zNear, GLfloat zFar) {
+        BasicMatrix<Affine> t;
+        t.loadIdentity();
         const GLfloat dx(right - left);
         const GLfloat dy(top - bottom);
         const GLfloat dz(zFar - zNear);
 
         if (dx != 0.0f && dy != 0.0f && dz != 0.0f) {
-            t.loadIdentity();
             t[0] = 2.0f / dx;
             t[5] = 2.0f / dy;
             t[10] = -2.0f / dz;
@@ -183,8 +295,9 @@ class Matrix {
     }
 
     // Create the perspective projection transformation matrix
-    static Matrix frustum(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat zNear, GLfloat zFar) {
-        Matrix t;
+    static constexpr BasicMatrix<Projective> frustum(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top,
+                                                      GLfloat zNear, GLfloat zFar) {
+        BasicMatrix<Projective> t;
         const GLfloat dx(right - left);
         const GLfloat dy(top - bottom);
         const GLfloat dz(zFar - zNear);
@@ -205,13 +318,13 @@ class Matrix {
     }
 
     // Create the perspective projection transformation matrix by specifying the angle of view
-    static Matrix perspective(GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar) {
-        Matrix t;
+    static constexpr BasicMatrix<Projective> perspective(GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar) {
+        BasicMatrix<Projective> t;
         const GLfloat dz(zFar - zNear);
 
         if (dz != 0.0f) {
             t.loadIdentity();
-            t[5] = 1.0f / tan(fovy * 0.5f);
+            t[5] = 1.0f / tangent(fovy * 0.5f);
             t[0] = t[5] / aspect;
             t[10] = -(zFar + zNear) / dz;
             t[11] = -1.0f;
@@ -220,4 +333,168 @@ class Matrix {
         }
         return t;
     }
+
+  private:
+    // Multiply 4x4 matrices in column-major order
+    //   Each column of t is the linear combination of the columns of a weighted by the column of b
+    //   a: Left-hand side matrix
+    //   b: Right-hand side matrix
+    //   t: Storage location of a * b
+    static constexpr void multiply(const GLfloat *a, const GLfloat *b, GLfloat *t) {
+        if (std::is_constant_evaluated()) {
+            for (int i = 0; i < 16; i++) {
+                const int j(i & 3), k(i & ~3);
+                t[i] = a[0 + j] * b[k + 0] + a[4 + j] * b[k + 1] + a[8 + j] * b[k + 2] + a[12 + j] * b[k + 3];
+            }
+            return;
+        }
+#if defined(__AVX__)
+        // Columns of a, duplicated into both halves of the register
+        const __m256 a0(_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a + 0)));
+        const __m256 a1(_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a + 4)));
+        const __m256 a2(_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a + 8)));
+        const __m256 a3(_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a + 12)));
+
+        // Compute two columns of the result at once
+        for (int k = 0; k < 16; k += 8) {
+            const __m256 bk(_mm256_loadu_ps(b + k));
+            __m256 tk(_mm256_mul_ps(a0, _mm256_permute_ps(bk, 0x00)));
+#if defined(__FMA__)
+            tk = _mm256_fmadd_ps(a1, _mm256_permute_ps(bk, 0x55), tk);
+            tk = _mm256_fmadd_ps(a2, _mm256_permute_ps(bk, 0xaa), tk);
+            tk = _mm256_fmadd_ps(a3, _mm256_permute_ps(bk, 0xff), tk);
+#else
+            tk = _mm256_add_ps(tk, _mm256_mul_ps(a1, _mm256_permute_ps(bk, 0x55)));
+            tk = _mm256_add_ps(tk, _mm256_mul_ps(a2, _mm256_permute_ps(bk, 0xaa)));
+            tk = _mm256_add_ps(tk, _mm256_mul_ps(a3, _mm256_permute_ps(bk, 0xff)));
+#endif
+            _mm256_storeu_ps(t + k, tk);
+        }
+#else
+        // Columns of a
+        const simd::float4 a0(simd::load(a + 0));
+        const simd::float4 a1(simd::load(a + 4));
+        const simd::float4 a2(simd::load(a + 8));
+        const simd::float4 a3(simd::load(a + 12));
+
+        // Compute one column of the result at a time
+        for (int k = 0; k < 16; k += 4) {
+            simd::float4 tk(simd::mul(a0, simd::splat(b[k + 0])));
+            tk = simd::madd(a1, simd::splat(b[k + 1]), tk);
+            tk = simd::madd(a2, simd::splat(b[k + 2]), tk);
+            tk = simd::madd(a3, simd::splat(b[k + 3]), tk);
+            simd::store(t + k, tk);
+        }
+#endif
+    }
+
+    // Multiply 4x4 matrices whose bottom rows are both (0, 0, 0, 1)
+    //   Skips the products with the known zeros of the bottom row of b, and writes the bottom row (0, 0, 0, 1) of the
+    //   result exactly on both paths
+    //   a: Left-hand side matrix
+    //   b: Right-hand side matrix
+    //   t: Storage location of a * b
+    static constexpr void multiplyAffine(const GLfloat *a, const GLfloat *b, GLfloat *t) {
+        if (std::is_constant_evaluated()) {
+            for (int k = 0; k < 16; k += 4) {
+                for (int j = 0; j < 3; ++j) {
+                    t[k + j] = a[0 + j] * b[k + 0] + a[4 + j] * b[k + 1] + a[8 + j] * b[k + 2];
+                }
+                t[k + 3] = 0.0f;
+            }
+            for (int j = 0; j < 3; ++j) {
+                t[12 + j] += a[12 + j];
+            }
+            t[15] = 1.0f;
+            return;
+        }
+
+        // Columns of a, the last elements of the first three are zero and of the last one is one
+        const simd::float4 a0(simd::load(a + 0));
+        const simd::float4 a1(simd::load(a + 4));
+        const simd::float4 a2(simd::load(a + 8));
+        const simd::float4 a3(simd::load(a + 12));
+
+        // Compute one column of the result at a time
+        for (int k = 0; k < 16; k += 4) {
+            simd::float4 tk(simd::mul(a0, simd::splat(b[k + 0])));
+            tk = simd::madd(a1, simd::splat(b[k + 1]), tk);
+            tk = simd::madd(a2, simd::splat(b[k + 2]), tk);
+            simd::store(t + k, k < 12 ? tk : simd::add(tk, a3));
+            t[k + 3] = k < 12 ? 0.0f : 1.0f;
+        }
+    }
+
+    // Square root that can also be evaluated at compile time
+    static constexpr GLfloat squareRoot(GLfloat x) {
+        if (!std::is_constant_evaluated()) {
+            return sqrt(x);
+        }
+        if (x <= 0.0f) {
+            return 0.0f;
+        }
+
+        // Newton's method
+        double r(x > 1.0f ? x : 1.0), q(0.0);
+        while (r != q) {
+            q = r;
+            r = 0.5 * (r + x / r);
+        }
+        return static_cast<GLfloat>(r);
+    }
+
+    // Sine of an angle in double precision by the Taylor series, for compile time evaluation
+    static constexpr double sineSeries(double a) {
+        // Reduce the angle to [-pi, pi]
+        constexpr double pi(3.14159265358979323846);
+        const double n(static_cast<double>(static_cast<long long>(a / (2.0 * pi) + (a < 0.0 ? -0.5 : 0.5))));
+        const double x(a - n * 2.0 * pi);
+
+        double term(x), sum(x);
+        for (int i = 1; i < 16; ++i) {
+            term *= -x * x / ((2 * i) * (2 * i + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Sine that can also be evaluated at compile time
+    static constexpr GLfloat sine(GLfloat a) {
+        if (!std::is_constant_evaluated()) {
+            return sin(a);
+        }
+        return static_cast<GLfloat>(sineSeries(a));
+    }
+
+    // Cosine that can also be evaluated at compile time
+    static constexpr GLfloat cosine(GLfloat a) {
+        if (!std::is_constant_evaluated()) {
+            return cos(a);
+        }
+        return static_cast<GLfloat>(sineSeries(a + 1.57079632679489661923));
+    }
+
+    // Tangent that can also be evaluated at compile time
+    static constexpr GLfloat tangent(GLfloat a) {
+        if (!std::is_constant_evaluated()) {
+            return tan(a);
+        }
+        return static_cast<GLfloat>(sineSeries(a) / sineSeries(a + 1.57079632679489661923));
+    }
 };
+
+// General transformation matrix
+using Matrix = BasicMatrix<Projective>;
+
+// Transformation matrix that keeps the bottom row (0, 0, 0, 1)
+using AffineMatrix = BasicMatrix<Affine>;
+
+// Transformation matrix made of a rotation and a translation
+using RigidMatrix = BasicMatrix<Rigid>;
+
+// The kinds must hold for the results of the factories and the products, also for degenerate arguments
+static_assert(RigidMatrix::rotate(1.0f, 0.0f, 0.0f, 0.0f)[0] == 1.0f &&
+              RigidMatrix::rotate(1.0f, 0.0f, 0.0f, 0.0f)[15] == 1.0f);
+static_assert(AffineMatrix::orthogonal(1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 10.0f)[15] == 1.0f);
+static_assert((AffineMatrix::scale(2.0f, 3.0f, 4.0f) * RigidMatrix::translate(1.0f, 2.0f, 3.0f))[3] == 0.0f &&
+              (AffineMatrix::scale(2.0f, 3.0f, 4.0f) * RigidMatrix::translate(1.0f, 2.0f, 3.0f))[15] == 1.0f);
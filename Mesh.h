@@ -0,0 +1,349 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Graphic data
+#include "Object.h"
+
+// Pool of worker threads
+#include "JobSystem.h"
+
+// Procedural mesh made of rectangular grids of vertices
+//   The numbers of vertices and indices are known before generating, so the mesh is written straight into a buffer of
+//   the caller, such as a mapped buffer object, and the rows of the grids are generated in parallel
+class Mesh {
+    // Grid of (columns + 1) x (rows + 1) vertices with two triangles in each cell
+    struct Patch {
+        // Number of cells in each direction
+        int columns, rows;
+        // Offsets of the first vertex and the first index
+        std::size_t vertex, index;
+    };
+
+    // Grids of the mesh
+    std::vector<Patch> patches;
+
+    // Number of vertices and indices of all grids
+    std::size_t vertexcount{}, indexcount{};
+
+  protected:
+    // Add a grid
+    //   columns: Number of cells across
+    //   rows   : Number of cells down
+    void addPatch(int columns, int rows) {
+        patches.push_back({columns, rows, vertexcount, indexcount});
+        vertexcount += static_cast<std::size_t>(columns + 1) * (rows + 1);
+        indexcount += static_cast<std::size_t>(columns) * rows * 6;
+    }
+
+    // Generate the vertices of a row of a grid
+    //   The triangles face the outside when the row goes down and the column goes to the right, seen from outside
+    //   patch : Index of the grid
+    //   row   : Row of vertices from 0 to rows
+    //   vertex: Destination of the columns + 1 vertices of the row
+    virtual void generateRow(std::size_t patch, int row, Object::Vertex *vertex) const = 0;
+
+  public:
+    // Destructor
+    virtual ~Mesh() = default;
+
+    // Create the procedural mesh of a shape
+    //   name: Name of the shape, sphere, cube, torus, cylinder or plane
+    //   n, m: Number of divisions, only n is used for the cube
+    //   Returns nullptr for an unknown name
+    static Mesh *create(std::string_view name, int n, int m);
+
+    // Whether a name is that of a shape create() knows
+    //   name: Name of the shape
+    static bool isShape(std::string_view name) { return std::unique_ptr<const Mesh>(create(name, 1, 1)) != nullptr; }
+
+    // Number of vertices
+    [[nodiscard]] GLsizei getVertexCount() const { return static_cast<GLsizei>(vertexcount); }
+
+    // Number of elements at the vertex index
+    [[nodiscard]] GLsizei getIndexCount() const { return static_cast<GLsizei>(indexcount); }
+
+    // Number of triangles
+    [[nodiscard]] std::size_t getTriangleCount() const { return indexcount / 3; }
+
+    // Generate the vertex attributes and the indices
+    //   vertex: Destination of getVertexCount() vertex attributes
+    //   index : Destination of getIndexCount() indices
+    //   jobs  : Pool of worker threads generating the rows
+    void generate(Object::Vertex *vertex, GLuint *index, JobSystem &jobs) const {
+        // Every row of vertices of every grid, each one also writes the indices of the cells below it
+        std::vector<std::pair<std::size_t, int>> rows;
+        for (std::size_t p = 0; p < patches.size(); ++p) {
+            for (int row = 0; row <= patches[p].rows; ++row) {
+                rows.emplace_back(p, row);
+            }
+        }
+
+        // Jobs of about 16384 vertices, since smaller ones are not worth handing to another thread
+        const std::size_t grain(16384 * rows.size() / std::max<std::size_t>(vertexcount, 1) + 1);
+        jobs.parallelFor(rows.size(), grain, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t k = begin; k < end; ++k) {
+                const Patch &p(patches[rows[k].first]);
+                const int row(rows[k].second);
+                generateRow(rows[k].first, row, vertex + p.vertex + static_cast<std::size_t>(p.columns + 1) * row);
+                if (row < p.rows) {
+                    generateIndexRow(p, row, index + p.index + static_cast<std::size_t>(p.columns) * row * 6);
+                }
+            }
+        });
+    }
+
+    // Function filling the buffer objects of an Object with the mesh
+    //   jobs: Pool of worker threads generating the rows, which must outlive the function
+    [[nodiscard]] Object::Fill fill(JobSystem &jobs) const {
+        return [this, &jobs](Object::Vertex *vertex, GLuint *index) { generate(vertex, index, jobs); };
+    }
+
+  private:
+    // Generate the indices of a row of cells
+    //   p    : Grid
+    //   row  : Row of cells from 0 to rows - 1
+    //   index: Destination of the columns * 6 indices of the row
+    static void generateIndexRow(const Patch &p, int row, GLuint *index) {
+        const GLuint k(static_cast<GLuint>(p.vertex + static_cast<std::size_t>(p.columns + 1) * row));
+        for (int i = 0; i < p.columns; ++i) {
+            // Vertex index
+            const GLuint k0(k + i);
+            const GLuint k1(k0 + 1);
+            const GLuint k2(k1 + p.columns);
+            const GLuint k3(k2 + 1);
+            // Bottom left triangle
+            *index++ = k0;
+            *index++ = k2;
+            *index++ = k3;
+            // Upper right triangle
+            *index++ = k0;
+            *index++ = k3;
+            *index++ = k1;
+        }
+    }
+
+  protected:
+    // Sine and cosine of the angles of the columns of a full turn
+    //   columns: Number of cells around
+    static std::vector<std::pair<double, double>> circle(int columns) {
+        std::vector<std::pair<double, double>> c(columns + 1);
+        for (int i = 0; i <= columns; ++i) {
+            const float s(static_cast<float>(i) / static_cast<float>(columns));
+            c[i] = {std::sin(static_cast<double>(6.283185f * s)), std::cos(static_cast<double>(6.283185f * s))};
+        }
+        return c;
+    }
+};
+
+// Sphere of radius 1 around the origin
+class SphereMesh : public Mesh {
+    // Number of divisions around and from pole to pole
+    const int slices, stacks;
+
+    // Sine and cosine around
+    const std::vector<std::pair<double, double>> around;
+
+  public:
+    // Constructor
+    //   slices: Number of divisions around the y axis
+    //   stacks: Number of divisions from the north pole to the south pole
+    SphereMesh(int slices, int stacks) : slices(slices), stacks(stacks), around(circle(slices)) {
+        addPatch(slices, stacks);
+    }
+
+  protected:
+    // Generate the vertices of a row
+    void generateRow(std::size_t, int row, Object::Vertex *vertex) const override {
+        const float t(static_cast<float>(row) / static_cast<float>(stacks));
+        const float y(static_cast<float>(std::cos(static_cast<double>(3.141593f * t))));
+        const float r(static_cast<float>(std::sin(static_cast<double>(3.141593f * t))));
+        for (int i = 0; i <= slices; ++i) {
+            const float z(static_cast<float>(r * around[i].second)), x(static_cast<float>(r * around[i].first));
+            vertex[i] = {{x, y, z}, {x, y, z}};
+        }
+    }
+};
+
+// Torus around the y axis
+class TorusMesh : public Mesh {
+    // Number of divisions around the axis and around the tube
+    const int slices, stacks;
+
+    // Distance from the axis to the center of the tube and radius of the tube
+    const GLfloat radius, tube;
+
+    // Sine and cosine around the axis and around the tube
+    const std::vector<std::pair<double, double>> around, section;
+
+  public:
+    // Constructor
+    //   slices: Number of divisions around the y axis
+    //   stacks: Number of divisions around the tube
+    //   radius: Distance from the axis to the center of the tube
+    //   tube  : Radius of the tube
+    TorusMesh(int slices, int stacks, GLfloat radius = 1.0f, GLfloat tube = 0.25f)
+        : slices(slices), stacks(stacks), radius(radius), tube(tube), around(circle(slices)), section(circle(stacks)) {
+        addPatch(slices, stacks);
+    }
+
+  protected:
+    // Generate the vertices of a row, which starts at the top of the tube and goes outside first
+    void generateRow(std::size_t, int row, Object::Vertex *vertex) const override {
+        const GLfloat y(static_cast<GLfloat>(section[row].second)), r(static_cast<GLfloat>(section[row].first));
+        for (int i = 0; i <= slices; ++i) {
+            const GLfloat dx(static_cast<GLfloat>(around[i].first)), dz(static_cast<GLfloat>(around[i].second));
+            const GLfloat nx(r * dx), nz(r * dz);
+            vertex[i] = {{radius * dx + tube * nx, tube * y, radius * dz + tube * nz}, {nx, y, nz}};
+        }
+    }
+};
+
+// Cylinder along the y axis with caps
+class CylinderMesh : public Mesh {
+    // Number of divisions around and along the side
+    const int slices, stacks;
+
+    // Radius and height
+    const GLfloat radius, height;
+
+    // Sine and cosine around
+    const std::vector<std::pair<double, double>> around;
+
+  public:
+    // Constructor
+    //   slices: Number of divisions around the y axis
+    //   stacks: Number of divisions of the side along the y axis
+    //   radius: Radius
+    //   height: Height, the center is at the origin
+    CylinderMesh(int slices, int stacks, GLfloat radius = 1.0f, GLfloat height = 2.0f)
+        : slices(slices), stacks(stacks), radius(radius), height(height), around(circle(slices)) {
+        // Side, top cap and bottom cap, the caps are rings from the center to the rim
+        addPatch(slices, stacks);
+        addPatch(slices, 1);
+        addPatch(slices, 1);
+    }
+
+  protected:
+    // Generate the vertices of a row
+    void generateRow(std::size_t patch, int row, Object::Vertex *vertex) const override {
+        for (int i = 0; i <= slices; ++i) {
+            const GLfloat dx(static_cast<GLfloat>(around[i].first)), dz(static_cast<GLfloat>(around[i].second));
+            if (patch == 0) {
+                // The side goes down from the top
+                const GLfloat y(height * (0.5f - static_cast<GLfloat>(row) / static_cast<GLfloat>(stacks)));
+                vertex[i] = {{radius * dx, y, radius * dz}, {dx, 0.0f, dz}};
+            } else if (patch == 1) {
+                // The top cap goes out from the center
+                const GLfloat r(radius * static_cast<GLfloat>(row));
+                vertex[i] = {{r * dx, 0.5f * height, r * dz}, {0.0f, 1.0f, 0.0f}};
+            } else {
+                // The bottom cap goes in from the rim
+                const GLfloat r(radius * static_cast<GLfloat>(1 - row));
+                vertex[i] = {{r * dx, -0.5f * height, r * dz}, {0.0f, -1.0f, 0.0f}};
+            }
+        }
+    }
+};
+
+// Flat rectangular faces subdivided into grids
+class FaceMesh : public Mesh {
+    // Face
+    struct Face {
+        // Normal vector, and the directions of the columns and the rows scaled to the half size of the face
+        GLfloat normal[3], u[3], v[3];
+        // Center of the face
+        GLfloat center[3];
+    };
+
+    // Faces
+    std::vector<Face> faces;
+
+    // Number of divisions of each face
+    const int columns, rows;
+
+  protected:
+    // Constructor
+    //   columns: Number of divisions across each face
+    //   rows   : Number of divisions down each face
+    FaceMesh(int columns, int rows) : columns(columns), rows(rows) {}
+
+    // Add a face
+    //   The columns go along normal x v and the rows along v, so that the face is seen from the side of the normal
+    //   normal: Unit normal vector
+    //   v     : Unit direction of the rows, perpendicular to the normal
+    //   center: Center of the face
+    //   su, sv: Half size of the face across and down
+    void addFace(const GLfloat (&normal)[3], const GLfloat (&v)[3], const GLfloat (&center)[3], GLfloat su,
+                 GLfloat sv) {
+        const GLfloat u[3] = {normal[1] * v[2] - normal[2] * v[1], normal[2] * v[0] - normal[0] * v[2],
+                              normal[0] * v[1] - normal[1] * v[0]};
+        faces.push_back({{normal[0], normal[1], normal[2]},
+                         {u[0] * su, u[1] * su, u[2] * su},
+                         {v[0] * sv, v[1] * sv, v[2] * sv},
+                         {center[0], center[1], center[2]}});
+        addPatch(columns, rows);
+    }
+
+    // Generate the vertices of a row
+    void generateRow(std::size_t patch, int row, Object::Vertex *vertex) const override {
+        const Face &f(faces[patch]);
+        const GLfloat t(2.0f * static_cast<GLfloat>(row) / static_cast<GLfloat>(rows) - 1.0f);
+        for (int i = 0; i <= columns; ++i) {
+            const GLfloat s(2.0f * static_cast<GLfloat>(i) / static_cast<GLfloat>(columns) - 1.0f);
+            vertex[i] = {{f.center[0] + s * f.u[0] + t * f.v[0], f.center[1] + s * f.u[1] + t * f.v[1],
+                          f.center[2] + s * f.u[2] + t * f.v[2]},
+                         {f.normal[0], f.normal[1], f.normal[2]}};
+        }
+    }
+};
+
+// Plane on the xz plane facing up
+class PlaneMesh : public FaceMesh {
+  public:
+    // Constructor
+    //   columns: Number of divisions along the x axis
+    //   rows   : Number of divisions along the z axis
+    //   width  : Size along the x axis
+    //   depth  : Size along the z axis
+    PlaneMesh(int columns, int rows, GLfloat width = 2.0f, GLfloat depth = 2.0f) : FaceMesh(columns, rows) {
+        addFace({0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, 0.5f * width, 0.5f * depth);
+    }
+};
+
+// Cube from -1 to 1 with each face divided into a grid
+class CubeMesh : public FaceMesh {
+  public:
+    // Constructor
+    //   divisions: Number of divisions along each edge
+    explicit CubeMesh(int divisions) : FaceMesh(divisions, divisions) {
+        // Left, back, bottom, right, top and front
+        addFace({-1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, 1.0f, 1.0f);
+        addFace({0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, 1.0f, 1.0f);
+        addFace({0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}, 1.0f, 1.0f);
+        addFace({1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, 1.0f, 1.0f);
+        addFace({0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, 1.0f, 1.0f);
+        addFace({0.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, 1.0f, 1.0f);
+    }
+};
+
+inline Mesh *Mesh::create(std::string_view name, int n, int m) {
+    if (name == "sphere") {
+        return new SphereMesh(n, m);
+    } else if (name == "cube") {
+        return new CubeMesh(n);
+    } else if (name == "torus") {
+        return new TorusMesh(n, m);
+    } else if (name == "cylinder") {
+        return new CylinderMesh(n, m);
+    } else if (name == "plane") {
+        return new PlaneMesh(n, m);
+    }
+    return nullptr;
+}
@@ -0,0 +1,216 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+
+// Contents of a file mapped into memory
+#include "MappedFile.h"
+
+// Drawing objects
+#include "Object.h"
+
+// Mesh stored in a binary file that is mapped into memory and used in place
+//   The file is a header followed by the vertex attributes in the layout of Object::Vertex and the indices, so the
+//   mapped pages are passed to the buffer objects as they are, without parsing or copying them on the heap. The header
+//   describes the layout of the vertices, which must match the one of Object::Vertex, and the bounds of the positions.
+//   The numbers are stored in the byte order of the machine that wrote the file, and a file of another byte order is
+//   rejected by its version. The counts must fit in a GLsizei and every index must be less than the number of vertices,
+//   which is checked once when the file is opened so that a damaged file never makes the GPU read outside the buffer
+class MeshFile {
+  public:
+    // Vertex attribute in the layout descriptor
+    struct Attribute {
+        // Attribute location, number of components, type of the components, whether they are normalized, and the
+        // offset in the vertex
+        std::uint32_t location, size, type, normalized, offset;
+    };
+
+    // Header at the beginning of the file
+    struct Header {
+        // File identification and format version
+        char magic[4];
+        std::uint32_t version;
+        // Number of attributes used and the size of a vertex
+        std::uint32_t attributes;
+        std::uint32_t stride;
+        // Layout of a vertex
+        Attribute attribute[4];
+        // Type of the indices
+        std::uint32_t indexType;
+        std::uint32_t reserved;
+        // Number of vertices and of indices
+        std::uint64_t vertexCount, indexCount;
+        // Byte offsets of the vertices and of the indices from the beginning of the file
+        std::uint64_t vertexOffset, indexOffset;
+        // Lower and upper corners of the box around the positions
+        GLfloat lower[3], upper[3];
+    };
+
+    // Version of the file format
+    static constexpr std::uint32_t fileVersion = 1;
+
+  private:
+    // Mapped contents of the file
+    const MappedFile file;
+
+    // Header of a valid file, nullptr otherwise
+    const Header *header{};
+
+    // Layout of Object::Vertex
+    static constexpr Attribute layout[] = {
+        {0, 3, GL_FLOAT, GL_FALSE, static_cast<std::uint32_t>(offsetof(Object::Vertex, position))},
+        {1, 3, GL_FLOAT, GL_FALSE, static_cast<std::uint32_t>(offsetof(Object::Vertex, normal))},
+    };
+
+    // Alignment of the vertices and of the indices in the file
+    static constexpr std::uint64_t alignment = 64;
+
+  public:
+    // Constructor
+    //   path: Mesh file name
+    explicit MeshFile(const char *path) : file(path) {
+        if (!file) {
+            std::cerr << "Error: Can't open mesh file: " << path << std::endl;
+            return;
+        }
+        if (!valid()) {
+            std::cerr << "Error: Invalid mesh file: " << path << std::endl;
+            return;
+        }
+        header = reinterpret_cast<const Header *>(file.data());
+    }
+
+    // Destructor
+    virtual ~MeshFile() = default;
+
+    // Copy prohibition
+    MeshFile(const MeshFile &) = delete;
+    MeshFile &operator=(const MeshFile &) = delete;
+
+    // Whether the file was mapped and is valid
+    explicit operator bool() const { return header != nullptr; }
+
+    // Number of vertices
+    [[nodiscard]] GLsizei getVertexCount() const { return static_cast<GLsizei>(header->vertexCount); }
+
+    // Number of indices
+    [[nodiscard]] GLsizei getIndexCount() const { return static_cast<GLsizei>(header->indexCount); }
+
+    // Vertex attributes in the mapped file
+    [[nodiscard]] const Object::Vertex *getVertices() const {
+        return reinterpret_cast<const Object::Vertex *>(file.data() + header->vertexOffset);
+    }
+
+    // Indices in the mapped file
+    [[nodiscard]] const GLuint *getIndices() const {
+        return reinterpret_cast<const GLuint *>(file.data() + header->indexOffset);
+    }
+
+    // Lower corner of the box around the positions
+    [[nodiscard]] const GLfloat *getLower() const { return header->lower; }
+
+    // Upper corner of the box around the positions
+    [[nodiscard]] const GLfloat *getUpper() const { return header->upper; }
+
+    // Radius of the sphere around the origin containing the box
+    [[nodiscard]] GLfloat getRadius() const {
+        GLfloat r(0.0f);
+        for (int i = 0; i < 3; ++i) {
+            const GLfloat a(std::max(std::abs(header->lower[i]), std::abs(header->upper[i])));
+            r += a * a;
+        }
+        return std::sqrt(r);
+    }
+
+    // Write a mesh file
+    //   path       : Mesh file name
+    //   vertex     : Vertex attributes
+    //   vertexcount: Number of vertices
+    //   index      : Indices of the triangles
+    //   indexcount : Number of indices
+    //   Returns false if the file cannot be written
+    static bool write(const char *path, const Object::Vertex *vertex, std::size_t vertexcount, const GLuint *index,
+                      std::size_t indexcount) {
+        Header h{};
+        std::memcpy(h.magic, "GLMS", 4);
+        h.version = fileVersion;
+        h.attributes = static_cast<std::uint32_t>(std::size(layout));
+        h.stride = sizeof(Object::Vertex);
+        std::copy(std::begin(layout), std::end(layout), h.attribute);
+        h.indexType = GL_UNSIGNED_INT;
+        h.vertexCount = vertexcount;
+        h.indexCount = indexcount;
+        h.vertexOffset = align(sizeof h);
+        h.indexOffset = align(h.vertexOffset + vertexcount * sizeof(Object::Vertex));
+
+        // Box around the positions
+        for (int i = 0; i < 3; ++i) {
+            h.lower[i] = vertexcount > 0 ? INFINITY : 0.0f;
+            h.upper[i] = vertexcount > 0 ? -INFINITY : 0.0f;
+        }
+        for (std::size_t k = 0; k < vertexcount; ++k) {
+            for (int i = 0; i < 3; ++i) {
+                h.lower[i] = std::min(h.lower[i], vertex[k].position[i]);
+                h.upper[i] = std::max(h.upper[i], vertex[k].position[i]);
+            }
+        }
+
+        // Header, vertices and indices, each padded to its offset
+        std::ofstream output(path, std::ios::binary);
+        const char zero[alignment]{};
+        output.write(reinterpret_cast<const char *>(&h), sizeof h);
+        output.write(zero, static_cast<std::streamsize>(h.vertexOffset - sizeof h));
+        output.write(reinterpret_cast<const char *>(vertex),
+                     static_cast<std::streamsize>(vertexcount * sizeof *vertex));
+        output.write(zero, static_cast<std::streamsize>(h.indexOffset - h.vertexOffset - vertexcount * sizeof *vertex));
+        output.write(reinterpret_cast<const char *>(index), static_cast<std::streamsize>(indexcount * sizeof *index));
+        if (!output.flush()) {
+            std::cerr << "Error: Can't write mesh file: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+  private:
+    // Round up an offset to the alignment
+    static std::uint64_t align(std::uint64_t offset) { return (offset + alignment - 1) / alignment * alignment; }
+
+    // Whether the mapped contents are a mesh file of the layout of Object::Vertex
+    [[nodiscard]] bool valid() const {
+        const std::size_t length(file.size());
+        if (length < sizeof(Header)) {
+            return false;
+        }
+        const Header &h(*reinterpret_cast<const Header *>(file.data()));
+        if (std::memcmp(h.magic, "GLMS", 4) != 0 || h.version != fileVersion || h.stride != sizeof(Object::Vertex) ||
+            h.attributes != std::size(layout) || h.indexType != GL_UNSIGNED_INT) {
+            return false;
+        }
+        for (std::size_t i = 0; i < std::size(layout); ++i) {
+            const Attribute &a(h.attribute[i]), &b(layout[i]);
+            if (a.location != b.location || a.size != b.size || a.type != b.type || a.normalized != b.normalized ||
+                a.offset != b.offset) {
+                return false;
+            }
+        }
+
+        // Both arrays are aligned and inside the file, and their counts fit in the sizes OpenGL takes
+        constexpr std::uint64_t limit(std::numeric_limits<GLsizei>::max());
+        if (h.vertexOffset % alignof(Object::Vertex) != 0 || h.indexOffset % alignof(GLuint) != 0 ||
+            h.vertexOffset > length || h.vertexCount > (length - h.vertexOffset) / h.stride || h.indexOffset > length ||
+            h.indexCount > (length - h.indexOffset) / sizeof(GLuint) || h.vertexCount > limit || h.indexCount > limit) {
+            return false;
+        }
+
+        // Every index refers to a vertex
+        const GLuint *const index(reinterpret_cast<const GLuint *>(file.data() + h.indexOffset));
+        return std::all_of(index, index + h.indexCount, [&](GLuint i) { return i < h.vertexCount; });
+    }
+};
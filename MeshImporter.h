@@ -0,0 +1,953 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Pool of worker threads
+#include "JobSystem.h"
+
+// Contents of a file mapped into memory
+#include "MappedFile.h"
+
+// Drawing objects
+#include "Object.h"
+
+// Importer of Wavefront OBJ files and ASCII or binary PLY files into vertex attributes and indices of triangles
+//   The file is mapped into memory and split into pieces at line boundaries that the threads of a pool parse at the
+//   same time with std::from_chars. The pieces of an OBJ file are parsed a few at a time and joined in order, every
+//   pair of a position and a normal used by a corner becoming one vertex through a hash table split into shards by the
+//   hash, which the threads look up at the same time, and the pages already parsed are released, so the memory used
+//   follows the size of the mesh rather than the size of the file. The vertices are numbered in the order they are
+//   first used whatever the number of threads. Polygons are split into fans of triangles, and vertices without a normal
+//   get the sum of the normals of the triangles around them
+class MeshImporter {
+    // Number of bytes of a piece of an OBJ file
+    static constexpr std::size_t pieceSize = std::size_t(1) << 22;
+
+    // Number of lines of a piece of an element of an ASCII PLY file, or of items of a binary one
+    static constexpr std::size_t pieceLines = 65536;
+
+    // Index of a corner without a normal
+    static constexpr std::int64_t none = -1;
+
+    // Unused entry of the hash table of the vertices
+    static constexpr std::uint64_t empty = UINT64_MAX;
+
+    // Negative OBJ indices are counted back from the vertices of their piece and stored from here until the pieces
+    // before are joined
+    static constexpr std::int64_t relative = INT64_MIN / 2;
+
+    // Number of shards of the hash table of the vertices of an OBJ file and its bits
+    static constexpr int shardBits = 6;
+    static constexpr std::size_t shards = std::size_t(1) << shardBits;
+
+    // Worker threads
+    JobSystem &jobs;
+
+    // Vertex attributes and indices of the triangles
+    std::vector<Object::Vertex> vertex;
+    std::vector<GLuint> index;
+
+    // Lower and upper corners of the box around the positions
+    GLfloat lower[3]{}, upper[3]{};
+
+    // Triangles of a piece of an OBJ file
+    struct ObjPiece {
+        // Positions and normals defined in the piece, 3 elements each
+        std::vector<GLfloat> position, normal;
+
+        // Position and normal of each corner of the triangles
+        std::vector<std::int64_t> corner;
+
+        // Pair of a position and a normal of each corner, replaced by its vertex in its shard
+        std::vector<std::uint64_t> pair;
+
+        // Corners whose pairs fall in each shard
+        std::vector<std::uint32_t> bucket[shards];
+    };
+
+    // Shard of the hash table from a pair of a position and a normal to a vertex
+    struct ObjShard {
+        // Open addressing table of pairs and their vertices in the shard
+        std::vector<std::uint64_t> keys;
+        std::vector<GLuint> values;
+        int bits;
+        // Pairs of the vertices of the shard in the order they are first used, and their vertices in the mesh
+        std::vector<std::uint64_t> unique;
+        std::vector<GLuint> global;
+    };
+
+    // Type of a value in a PLY file
+    enum Type : std::uint8_t { Int8, Uint8, Int16, Uint16, Int32, Uint32, Float32, Float64, Unknown };
+
+    // Property of an element of a PLY file
+    struct Property {
+        std::string name;
+        // Type of the values, and of the number of values for a list or Unknown otherwise
+        Type type, countType;
+    };
+
+    // Element of a PLY file
+    struct Element {
+        std::string name;
+        std::size_t count;
+        std::vector<Property> property;
+    };
+
+  public:
+    // Constructor
+    //   jobs: Pool of worker threads
+    explicit MeshImporter(JobSystem &jobs) : jobs(jobs) {}
+
+    // Destructor
+    virtual ~MeshImporter() = default;
+
+    // Copy prohibition
+    MeshImporter(const MeshImporter &) = delete;
+    MeshImporter &operator=(const MeshImporter &) = delete;
+
+    // Import a file, PLY if it begins with "ply", OBJ otherwise
+    //   path: OBJ or PLY file name
+    //   Returns false if the file cannot be read
+    bool load(const char *path) {
+        vertex.clear();
+        index.clear();
+        const MappedFile file(path);
+        if (!file) {
+            std::cerr << "Error: Can't open mesh file: " << path << std::endl;
+            return false;
+        }
+        const char *const begin(reinterpret_cast<const char *>(file.data())), *const end(begin + file.size());
+        file.sequential(0, file.size());
+        const bool ply(file.size() > 3 && std::memcmp(begin, "ply", 3) == 0 && (begin[3] == '\n' || begin[3] == '\r'));
+        bool normals(true);
+        if (!(ply ? loadPly(file, begin, end, normals) : loadObj(file, begin, end, normals))) {
+            std::cerr << "Error: Invalid " << (ply ? "PLY" : "OBJ") << " file: " << path << std::endl;
+            vertex.clear();
+            index.clear();
+            return false;
+        }
+        if (!normals) {
+            computeNormals();
+        }
+        computeBounds();
+        return true;
+    }
+
+    // Vertex attributes
+    [[nodiscard]] const std::vector<Object::Vertex> &getVertices() const { return vertex; }
+
+    // Indices of the triangles
+    [[nodiscard]] const std::vector<GLuint> &getIndices() const { return index; }
+
+    // Lower corner of the box around the positions
+    [[nodiscard]] const GLfloat *getLower() const { return lower; }
+
+    // Upper corner of the box around the positions
+    [[nodiscard]] const GLfloat *getUpper() const { return upper; }
+
+    // Radius of the sphere around the origin containing the box
+    [[nodiscard]] GLfloat getRadius() const {
+        GLfloat r(0.0f);
+        for (int i = 0; i < 3; ++i) {
+            const GLfloat a(std::max(std::abs(lower[i]), std::abs(upper[i])));
+            r += a * a;
+        }
+        return std::sqrt(r);
+    }
+
+  private:
+    // Run a function for each item on the threads of the pool
+    //   count: Number of items
+    //   f    : Function called with the index of an item
+    template <typename F>
+    void parallel(std::size_t count, F &&f) const {
+        jobs.parallelFor(count, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t k = begin; k < end; ++k) {
+                f(k);
+            }
+        });
+    }
+
+    // Skip the spaces in a line
+    static const char *skip(const char *p, const char *end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+            ++p;
+        }
+        return p;
+    }
+
+    // Beginning of the next line
+    static const char *nextLine(const char *p, const char *end) {
+        const void *const q(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        return q != nullptr ? static_cast<const char *>(q) + 1 : end;
+    }
+
+    // Parse a number after spaces
+    //   p    : Position in the text, moved after the number
+    //   end  : End of the line
+    //   value: Storage location of the number
+    //   Returns false if there is no number
+    template <typename T>
+    static bool number(const char *&p, const char *end, T &value) {
+        p = skip(p, end);
+        if (p < end && *p == '+') {
+            ++p;
+        }
+        const auto [q, ec](std::from_chars(p, end, value));
+        if (ec != std::errc()) {
+            return false;
+        }
+        p = q;
+        return true;
+    }
+
+    // Import an OBJ file
+    //   file   : Mapped file
+    //   begin  : Beginning of the contents
+    //   end    : End of the contents
+    //   normals: Storage location of whether every vertex has a normal
+    //   Returns false if the file is invalid
+    bool loadObj(const MappedFile &file, const char *begin, const char *end, bool &normals) {
+        // Positions and normals of the whole file, 3 elements each
+        std::vector<GLfloat> position, normal;
+
+        // Hash table from a pair of a position and a normal used by a corner to a vertex, split by the top bits of the
+        // hash so that each shard is looked up by one thread
+        std::vector<ObjShard> table(shards);
+        for (ObjShard &t : table) {
+            t.bits = 10;
+            t.keys.assign(std::size_t(1) << t.bits, empty);
+            t.values.resize(t.keys.size());
+        }
+
+        // Pairs of each vertex in the order they are first used
+        std::vector<std::uint64_t> unique;
+
+        // A few pieces for each thread at a time, whose buffers are used again for the next pieces
+        std::vector<ObjPiece> pieces(2 * jobs.size());
+        std::vector<const char *> bounds;
+        std::vector<std::size_t> positionBase, normalBase, indexBase, vertexBase;
+        for (const char *p = begin; p < end;) {
+            bounds.assign(1, p);
+            while (bounds.size() <= pieces.size() && bounds.back() < end) {
+                const char *const q(bounds.back() + std::min(pieceSize, static_cast<std::size_t>(end - bounds.back())));
+                bounds.push_back(q < end ? nextLine(q, end) : end);
+            }
+            const std::size_t count(bounds.size() - 1);
+            parallel(count, [&](std::size_t k) { parseObj(bounds[k], bounds[k + 1], pieces[k]); });
+
+            // Where the positions, normals and indices of each piece go
+            positionBase.assign(1, position.size());
+            normalBase.assign(1, normal.size());
+            indexBase.assign(1, index.size());
+            for (std::size_t k = 0; k < count; ++k) {
+                positionBase.push_back(positionBase[k] + pieces[k].position.size());
+                normalBase.push_back(normalBase[k] + pieces[k].normal.size());
+                indexBase.push_back(indexBase[k] + pieces[k].corner.size() / 2);
+            }
+            position.resize(positionBase[count]);
+            normal.resize(normalBase[count]);
+            index.resize(indexBase[count]);
+
+            // Pairs of the corners counted from the beginning of the file, sorted into the shards
+            std::atomic<bool> valid(true);
+            parallel(count, [&](std::size_t k) {
+                ObjPiece &piece(pieces[k]);
+                std::copy(piece.position.begin(), piece.position.end(), position.begin() + positionBase[k]);
+                std::copy(piece.normal.begin(), piece.normal.end(), normal.begin() + normalBase[k]);
+                for (std::vector<std::uint32_t> &b : piece.bucket) {
+                    b.clear();
+                }
+                piece.pair.resize(piece.corner.size() / 2);
+                for (std::size_t c = 0; c < piece.pair.size(); ++c) {
+                    std::int64_t v(piece.corner[2 * c]), n(piece.corner[2 * c + 1]);
+                    if (v < relative / 2) {
+                        v += static_cast<std::int64_t>(positionBase[k] / 3) - relative;
+                    }
+                    if (n < relative / 2) {
+                        n += static_cast<std::int64_t>(normalBase[k] / 3) - relative;
+                    }
+                    if (v < 0 || v >= INT64_C(0xffffffff) || n < none || n >= INT64_C(0xfffffffe)) {
+                        valid.store(false, std::memory_order_relaxed);
+                        return;
+                    }
+                    piece.pair[c] = static_cast<std::uint64_t>(v) << 32 | static_cast<std::uint64_t>(n + 1);
+                    piece.bucket[hash(piece.pair[c]) >> (64 - shardBits)].push_back(static_cast<std::uint32_t>(c));
+                }
+            });
+            if (!valid) {
+                return false;
+            }
+
+            // Each shard looks up its pairs in the order of the corners, and a corner gets its vertex in the shard
+            // times 2 plus 1 if it uses the vertex first, above the bits of the shard
+            parallel(shards, [&](std::size_t s) {
+                ObjShard &t(table[s]);
+                for (std::size_t k = 0; k < count; ++k) {
+                    ObjPiece &piece(pieces[k]);
+                    for (const std::uint32_t c : piece.bucket[s]) {
+                        const std::size_t vertices(t.unique.size());
+                        const GLuint v(find(t, piece.pair[c]));
+                        piece.pair[c] = (std::uint64_t(v) << 1 | (v == vertices ? 1 : 0)) << shardBits | s;
+                    }
+                }
+                t.global.resize(t.unique.size());
+            });
+
+            // The vertices are numbered across the shards in the order of the corners using them first
+            vertexBase.assign(count + 1, 0);
+            parallel(count, [&](std::size_t k) {
+                vertexBase[k + 1] = static_cast<std::size_t>(
+                    std::count_if(pieces[k].pair.begin(), pieces[k].pair.end(),
+                                  [](std::uint64_t c) { return (c >> shardBits & 1) != 0; }));
+            });
+            vertexBase[0] = unique.size();
+            for (std::size_t k = 0; k < count; ++k) {
+                vertexBase[k + 1] += vertexBase[k];
+            }
+            unique.resize(vertexBase[count]);
+            if (unique.size() > 0xffffffff) {
+                return false;
+            }
+            parallel(count, [&](std::size_t k) {
+                std::size_t next(vertexBase[k]);
+                for (const std::uint64_t c : pieces[k].pair) {
+                    if ((c >> shardBits & 1) != 0) {
+                        ObjShard &t(table[c & (shards - 1)]);
+                        const std::size_t v(c >> (shardBits + 1));
+                        t.global[v] = static_cast<GLuint>(next);
+                        unique[next++] = t.unique[v];
+                    }
+                }
+            });
+
+            // Indices of the corners
+            parallel(count, [&](std::size_t k) {
+                GLuint *const out(&index[indexBase[k]]);
+                const std::vector<std::uint64_t> &pair(pieces[k].pair);
+                for (std::size_t c = 0; c < pair.size(); ++c) {
+                    out[c] = table[pair[c] & (shards - 1)].global[pair[c] >> (shardBits + 1)];
+                }
+            });
+            file.release(static_cast<std::size_t>(p - begin), static_cast<std::size_t>(bounds.back() - begin));
+            p = bounds.back();
+        }
+
+        // Vertex attributes of the pairs
+        vertex.resize(unique.size());
+        std::atomic<bool> valid(true), complete(true);
+        parallel((unique.size() + pieceLines - 1) / pieceLines, [&](std::size_t piece) {
+            const std::size_t last(std::min(unique.size(), (piece + 1) * pieceLines));
+            for (std::size_t k = piece * pieceLines; k < last; ++k) {
+                const std::size_t v(unique[k] >> 32), n(unique[k] & 0xffffffff);
+                Object::Vertex &out(vertex[k]);
+                if (3 * v + 2 >= position.size() || 3 * n > normal.size()) {
+                    valid.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+                std::copy(&position[3 * v], &position[3 * v] + 3, out.position);
+                if (n > 0) {
+                    std::copy(&normal[3 * n - 3], &normal[3 * n], out.normal);
+                } else {
+                    std::fill(out.normal, out.normal + 3, 0.0f);
+                    complete.store(false, std::memory_order_relaxed);
+                }
+            }
+        });
+        normals = complete;
+        return valid;
+    }
+
+    // Hash of a pair of a position and a normal, whose top bits select the shard
+    static std::uint64_t hash(std::uint64_t key) { return key * 0x9e3779b97f4a7c15ull; }
+
+    // Vertex of a pair of a position and a normal in a shard, a new one if the pair is not found
+    //   t  : Shard, whose table is doubled when half full
+    //   key: Pair of a position and a normal
+    //   Returns the vertex in the shard
+    static GLuint find(ObjShard &t, std::uint64_t key) {
+        if (2 * (t.unique.size() + 1) > t.keys.size()) {
+            ++t.bits;
+            t.keys.assign(std::size_t(1) << t.bits, empty);
+            t.values.resize(t.keys.size());
+            for (std::size_t k = 0; k < t.unique.size(); ++k) {
+                insert(t, t.unique[k], static_cast<GLuint>(k));
+            }
+        }
+        const GLuint v(insert(t, key, static_cast<GLuint>(t.unique.size())));
+        if (v == t.unique.size()) {
+            t.unique.push_back(key);
+        }
+        return v;
+    }
+
+    // Insert a pair into the table of a shard unless it is there
+    //   t    : Shard
+    //   key  : Pair of a position and a normal
+    //   value: Vertex of a new pair
+    //   Returns the vertex of the pair
+    static GLuint insert(ObjShard &t, std::uint64_t key, GLuint value) {
+        const std::size_t mask(t.keys.size() - 1);
+        for (std::size_t h = (hash(key) << shardBits) >> (64 - t.bits);; h = (h + 1) & mask) {
+            if (t.keys[h] == empty) {
+                t.keys[h] = key;
+                t.values[h] = value;
+                return value;
+            }
+            if (t.keys[h] == key) {
+                return t.values[h];
+            }
+        }
+    }
+
+    // Parse a piece of an OBJ file
+    //   p    : Beginning of the piece at the beginning of a line
+    //   end  : End of the piece at the end of a line
+    //   piece: Storage location of the positions, normals and triangles of the piece
+    static void parseObj(const char *p, const char *end, ObjPiece &piece) {
+        piece.position.clear();
+        piece.normal.clear();
+        piece.corner.clear();
+        std::vector<std::int64_t> polygon;
+        while (p < end) {
+            const char *const line(skip(p, end));
+            p = nextLine(line, end);
+            if (p - line < 3 || (line[1] != ' ' && line[1] != '\t' && line[1] != 'n')) {
+                continue;
+            }
+            const char *q(line + 1);
+            if (line[0] == 'v') {
+                // Position or normal, both with 3 components
+                std::vector<GLfloat> &a(line[1] == 'n' ? piece.normal : piece.position);
+                if (line[1] == 'n') {
+                    ++q;
+                }
+                GLfloat v[3]{};
+                for (GLfloat &x : v) {
+                    number(q, p, x);
+                }
+                a.insert(a.end(), v, v + 3);
+            } else if (line[0] == 'f' && line[1] != 'n') {
+                // Position, texture coordinates and normal of each corner, only the first one required
+                const std::int64_t positions(static_cast<std::int64_t>(piece.position.size() / 3));
+                const std::int64_t normals(static_cast<std::int64_t>(piece.normal.size() / 3));
+                polygon.clear();
+                for (std::int64_t v; number(q, p, v);) {
+                    std::int64_t t, n(0);
+                    if (q < p && *q == '/') {
+                        ++q;
+                        if (q < p && *q != '/') {
+                            number(q, p, t);
+                        }
+                        if (q < p && *q == '/') {
+                            ++q;
+                            number(q, p, n);
+                        }
+                    }
+                    polygon.push_back(v > 0 ? v - 1 : v < 0 ? relative + positions + v : -2);
+                    polygon.push_back(n > 0 ? n - 1 : n < 0 ? relative + normals + n : none);
+                }
+
+                // Fan of triangles around the first corner
+                for (std::size_t k = 4; k + 1 < polygon.size(); k += 2) {
+                    piece.corner.insert(piece.corner.end(), {polygon[0], polygon[1], polygon[k - 2], polygon[k - 1],
+                                                             polygon[k], polygon[k + 1]});
+                }
+            }
+        }
+    }
+
+    // Number of bytes of a PLY type
+    static std::size_t sizeOf(Type type) {
+        static constexpr std::size_t size[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+        return size[type];
+    }
+
+    // PLY type of a name
+    static Type typeOf(const std::string &name) {
+        static constexpr std::string_view names[][2] = {{"char", "int8"},   {"uchar", "uint8"},     {"short", "int16"},
+                                                        {"ushort", "uint16"}, {"int", "int32"},     {"uint", "uint32"},
+                                                        {"float", "float32"}, {"double", "float64"}};
+        for (int t = 0; t < Unknown; ++t) {
+            if (name == names[t][0] || name == names[t][1]) {
+                return static_cast<Type>(t);
+            }
+        }
+        return Unknown;
+    }
+
+    // Read a binary PLY value
+    //   p   : Location of the value
+    //   type: Type of the value
+    //   swap: Whether the bytes are in the other order
+    static double read(const unsigned char *p, Type type, bool swap) {
+        unsigned char b[8];
+        std::memcpy(b, p, sizeOf(type));
+        if (swap) {
+            std::reverse(b, b + sizeOf(type));
+        }
+        switch (type) {
+        case Int8:
+            return static_cast<double>(static_cast<std::int8_t>(b[0]));
+        case Uint8:
+            return static_cast<double>(b[0]);
+        case Int16:
+            return as<std::int16_t>(b);
+        case Uint16:
+            return as<std::uint16_t>(b);
+        case Int32:
+            return as<std::int32_t>(b);
+        case Uint32:
+            return as<std::uint32_t>(b);
+        case Float32:
+            return as<float>(b);
+        default:
+            return as<double>(b);
+        }
+    }
+
+    // Value of a type in bytes
+    template <typename T>
+    static double as(const unsigned char *b) {
+        T v;
+        std::memcpy(&v, b, sizeof v);
+        return static_cast<double>(v);
+    }
+
+    // Import a PLY file
+    //   file   : Mapped file
+    //   begin  : Beginning of the contents
+    //   end    : End of the contents
+    //   normals: Storage location of whether every vertex has a normal
+    //   Returns false if the file is invalid or has no vertex element
+    bool loadPly(const MappedFile &file, const char *begin, const char *end, bool &normals) {
+        // Header up to the line of end_header
+        std::vector<Element> element;
+        bool binary(false), swap(false);
+        const char *p(begin);
+        for (bool header(true); header;) {
+            if (p >= end) {
+                return false;
+            }
+            const char *const line(p);
+            p = nextLine(p, end);
+            std::istringstream s(std::string(line, p));
+            std::string word;
+            s >> word;
+            if (word == "format") {
+                s >> word;
+                binary = word != "ascii";
+                swap = binary && (word == "binary_little_endian") != (std::endian::native == std::endian::little);
+            } else if (word == "element") {
+                Element &e(element.emplace_back());
+                s >> e.name >> e.count;
+            } else if (word == "property" && !element.empty()) {
+                Property &r(element.back().property.emplace_back());
+                std::string type;
+                s >> type;
+                r.countType = Unknown;
+                if (type == "list") {
+                    s >> type;
+                    r.countType = typeOf(type);
+                    if (r.countType == Unknown || r.countType >= Float32) {
+                        return false;
+                    }
+                    s >> type;
+                }
+                r.type = typeOf(type);
+                s >> r.name;
+                if (r.type == Unknown) {
+                    return false;
+                }
+            } else if (word == "end_header") {
+                header = false;
+            }
+        }
+
+        // Elements in the order of the header
+        normals = false;
+        bool vertices(false);
+        for (const Element &e : element) {
+            const char *const start(p);
+            bool valid;
+            if (e.name == "vertex") {
+                valid = vertices = loadPlyVertices(e, binary, swap, p, end, normals);
+            } else if (e.name == "face") {
+                valid = loadPlyFaces(e, binary, swap, p, end);
+            } else {
+                valid = skipPly(e, binary, swap, p, end);
+            }
+            if (!valid) {
+                return false;
+            }
+            file.release(static_cast<std::size_t>(start - begin), static_cast<std::size_t>(p - begin));
+        }
+
+        // Every index refers to a vertex
+        std::atomic<bool> valid(vertices);
+        parallel((index.size() + pieceLines - 1) / pieceLines, [&](std::size_t piece) {
+            const std::size_t last(std::min(index.size(), (piece + 1) * pieceLines));
+            if (std::any_of(&index[piece * pieceLines], index.data() + last,
+                            [this](GLuint i) { return i >= vertex.size(); })) {
+                valid.store(false, std::memory_order_relaxed);
+            }
+        });
+        return valid;
+    }
+
+    // Beginnings of the pieces of lines of an element of an ASCII PLY file
+    //   count: Number of lines
+    //   p    : Beginning of the lines, moved after them
+    //   end  : End of the contents
+    //   Returns the beginnings of the pieces and the end of the lines, or nothing if the file ends before
+    static std::vector<const char *> pieceLinesOf(std::size_t count, const char *&p, const char *end) {
+        std::vector<const char *> bounds;
+        for (std::size_t k = 0; k < count; ++k) {
+            if (p >= end) {
+                return {};
+            }
+            if (k % pieceLines == 0) {
+                bounds.push_back(p);
+            }
+            p = nextLine(p, end);
+        }
+        bounds.push_back(p);
+        return bounds;
+    }
+
+    // Read the vertex element of a PLY file
+    //   e      : Element
+    //   binary : Whether the file is binary
+    //   swap   : Whether the bytes are in the other order
+    //   p      : Beginning of the element, moved after it
+    //   end    : End of the contents
+    //   normals: Storage location of whether the vertices have normals
+    //   Returns false if the element is invalid
+    bool loadPlyVertices(const Element &e, bool binary, bool swap, const char *&p, const char *end, bool &normals) {
+        // Properties of the position and the normal, and their offsets in a binary vertex
+        static constexpr const char *names[] = {"x", "y", "z", "nx", "ny", "nz"};
+        int column[6]{-1, -1, -1, -1, -1, -1};
+        std::size_t offset[6]{}, stride(0);
+        for (std::size_t i = 0; i < e.property.size(); ++i) {
+            const Property &r(e.property[i]);
+            if (r.countType != Unknown) {
+                return false;
+            }
+            for (int c = 0; c < 6; ++c) {
+                if (r.name == names[c]) {
+                    column[c] = static_cast<int>(i);
+                    offset[c] = stride;
+                }
+            }
+            stride += sizeOf(r.type);
+        }
+        if (column[0] < 0 || column[1] < 0 || column[2] < 0) {
+            return false;
+        }
+        normals = column[3] >= 0 && column[4] >= 0 && column[5] >= 0;
+        const int columns(normals ? 6 : 3);
+
+        if (binary) {
+            // Fixed size vertices read where they are, once the file is known to hold all of them
+            if (static_cast<std::size_t>(end - p) / std::max<std::size_t>(stride, 1) < e.count) {
+                return false;
+            }
+            vertex.resize(e.count);
+            const unsigned char *const data(reinterpret_cast<const unsigned char *>(p));
+            parallel((e.count + pieceLines - 1) / pieceLines, [&](std::size_t piece) {
+                const std::size_t last(std::min(e.count, (piece + 1) * pieceLines));
+                for (std::size_t k = piece * pieceLines; k < last; ++k) {
+                    GLfloat *const out[6]{&vertex[k].position[0], &vertex[k].position[1], &vertex[k].position[2],
+                                          &vertex[k].normal[0],   &vertex[k].normal[1],   &vertex[k].normal[2]};
+                    for (int c = 0; c < columns; ++c) {
+                        *out[c] = static_cast<GLfloat>(
+                            read(data + k * stride + offset[c], e.property[column[c]].type, swap));
+                    }
+                    if (!normals) {
+                        std::fill(vertex[k].normal, vertex[k].normal + 3, 0.0f);
+                    }
+                }
+            });
+            p += e.count * stride;
+            return true;
+        }
+
+        // A line of numbers for each vertex, once the file is known to hold all of them
+        const std::vector<const char *> bounds(pieceLinesOf(e.count, p, end));
+        if (bounds.empty() && e.count > 0) {
+            return false;
+        }
+        vertex.resize(e.count);
+        std::atomic<bool> valid(true);
+        parallel(bounds.size() > 0 ? bounds.size() - 1 : 0, [&](std::size_t piece) {
+            std::vector<double> value(e.property.size());
+            const char *q(bounds[piece]);
+            const std::size_t last(std::min(e.count, (piece + 1) * pieceLines));
+            for (std::size_t k = piece * pieceLines; k < last; ++k) {
+                const char *const eol(nextLine(q, bounds[piece + 1]));
+                for (double &v : value) {
+                    if (!number(q, eol, v)) {
+                        valid.store(false, std::memory_order_relaxed);
+                    }
+                }
+                for (int c = 0; c < 3; ++c) {
+                    vertex[k].position[c] = static_cast<GLfloat>(value[column[c]]);
+                    vertex[k].normal[c] = normals ? static_cast<GLfloat>(value[column[c + 3]]) : 0.0f;
+                }
+                q = eol;
+            }
+        });
+        return valid;
+    }
+
+    // Read the face element of a PLY file
+    //   e     : Element
+    //   binary: Whether the file is binary
+    //   swap  : Whether the bytes are in the other order
+    //   p     : Beginning of the element, moved after it
+    //   end   : End of the contents
+    //   Returns false if the element is invalid
+    bool loadPlyFaces(const Element &e, bool binary, bool swap, const char *&p, const char *end) {
+        // List of the indices of the vertices
+        std::size_t list(e.property.size());
+        for (std::size_t i = 0; i < e.property.size(); ++i) {
+            if (e.property[i].countType != Unknown &&
+                (e.property[i].name == "vertex_indices" || e.property[i].name == "vertex_index")) {
+                list = i;
+            }
+        }
+        if (list == e.property.size()) {
+            return false;
+        }
+        const Property &r(e.property[list]);
+
+        if (binary) {
+            // Triangles of fixed size read where they are, as long as every face is a triangle
+            const std::size_t countSize(sizeOf(r.countType)), indexSize(sizeOf(r.type));
+            const std::size_t stride(countSize + 3 * indexSize);
+            const unsigned char *const data(reinterpret_cast<const unsigned char *>(p));
+            if (e.property.size() == 1 && static_cast<std::size_t>(end - p) / stride >= e.count) {
+                const std::size_t first(index.size());
+                index.resize(first + 3 * e.count);
+                std::atomic<bool> triangles(true), valid(true);
+                parallel((e.count + pieceLines - 1) / pieceLines, [&](std::size_t piece) {
+                    const std::size_t last(std::min(e.count, (piece + 1) * pieceLines));
+                    for (std::size_t k = piece * pieceLines; k < last; ++k) {
+                        const unsigned char *const face(data + k * stride);
+                        if (read(face, r.countType, swap) != 3.0) {
+                            triangles.store(false, std::memory_order_relaxed);
+                            return;
+                        }
+                        for (std::size_t c = 0; c < 3; ++c) {
+                            if (!toIndex(read(face + countSize + c * indexSize, r.type, swap),
+                                         index[first + 3 * k + c])) {
+                                valid.store(false, std::memory_order_relaxed);
+                            }
+                        }
+                    }
+                });
+                if (!valid) {
+                    return false;
+                }
+                if (triangles) {
+                    p += e.count * stride;
+                    return true;
+                }
+                index.resize(first);
+            }
+
+            // Faces of any size one after another
+            std::vector<GLuint> polygon;
+            const unsigned char *q(data), *const last(reinterpret_cast<const unsigned char *>(end));
+            for (std::size_t k = 0; k < e.count; ++k) {
+                for (std::size_t i = 0; i < e.property.size(); ++i) {
+                    const Property &s(e.property[i]);
+                    std::size_t n(1);
+                    if (s.countType != Unknown) {
+                        if (static_cast<std::size_t>(last - q) < sizeOf(s.countType)) {
+                            return false;
+                        }
+                        n = static_cast<std::size_t>(read(q, s.countType, swap));
+                        q += sizeOf(s.countType);
+                    }
+                    if (static_cast<std::size_t>(last - q) / sizeOf(s.type) < n) {
+                        return false;
+                    }
+                    if (i == list) {
+                        polygon.resize(n);
+                        for (std::size_t c = 0; c < n; ++c) {
+                            if (!toIndex(read(q + c * sizeOf(s.type), s.type, swap), polygon[c])) {
+                                return false;
+                            }
+                        }
+                        fan(polygon, index);
+                    }
+                    q += n * sizeOf(s.type);
+                }
+            }
+            p = reinterpret_cast<const char *>(q);
+            return true;
+        }
+
+        // A line for each face, whose triangles are joined in order
+        const std::vector<const char *> bounds(pieceLinesOf(e.count, p, end));
+        if (bounds.empty() && e.count > 0) {
+            return false;
+        }
+        const std::size_t pieces(bounds.size() > 0 ? bounds.size() - 1 : 0);
+        std::vector<std::vector<GLuint>> triangles(pieces);
+        std::atomic<bool> valid(true);
+        parallel(pieces, [&](std::size_t piece) {
+            std::vector<GLuint> polygon;
+            for (const char *q = bounds[piece]; q < bounds[piece + 1];) {
+                const char *const eol(nextLine(q, bounds[piece + 1]));
+                for (std::size_t i = 0; i < e.property.size(); ++i) {
+                    std::size_t n(1);
+                    if (e.property[i].countType != Unknown && !number(q, eol, n)) {
+                        valid.store(false, std::memory_order_relaxed);
+                    }
+
+                    // The other properties, which may be negative, are skipped
+                    if (i != list) {
+                        for (std::size_t c = 0; c < n; ++c) {
+                            double v;
+                            if (!number(q, eol, v)) {
+                                valid.store(false, std::memory_order_relaxed);
+                                break;
+                            }
+                        }
+                        continue;
+                    }
+                    polygon.clear();
+                    for (std::size_t c = 0; c < n; ++c) {
+                        double v;
+                        GLuint k;
+                        if (!number(q, eol, v) || !toIndex(v, k)) {
+                            valid.store(false, std::memory_order_relaxed);
+                            break;
+                        }
+                        polygon.push_back(k);
+                    }
+                    fan(polygon, triangles[piece]);
+                }
+                q = eol;
+            }
+        });
+        for (const std::vector<GLuint> &t : triangles) {
+            index.insert(index.end(), t.begin(), t.end());
+        }
+        return valid;
+    }
+
+    // Skip an element of a PLY file
+    //   e     : Element
+    //   binary: Whether the file is binary
+    //   swap  : Whether the bytes are in the other order
+    //   p     : Beginning of the element, moved after it
+    //   end   : End of the contents
+    //   Returns false if the file ends before the element
+    static bool skipPly(const Element &e, bool binary, bool swap, const char *&p, const char *end) {
+        if (!binary) {
+            return !pieceLinesOf(e.count, p, end).empty() || e.count == 0;
+        }
+        for (std::size_t k = 0; k < e.count; ++k) {
+            for (const Property &r : e.property) {
+                std::size_t n(1);
+                if (r.countType != Unknown) {
+                    if (static_cast<std::size_t>(end - p) < sizeOf(r.countType)) {
+                        return false;
+                    }
+                    n = static_cast<std::size_t>(read(reinterpret_cast<const unsigned char *>(p), r.countType, swap));
+                    p += sizeOf(r.countType);
+                }
+                if (static_cast<std::size_t>(end - p) / sizeOf(r.type) < n) {
+                    return false;
+                }
+                p += n * sizeOf(r.type);
+            }
+        }
+        return true;
+    }
+
+    // Index of a vertex read from a PLY file, which is then checked against the number of vertices
+    //   v    : Value read
+    //   index: Storage location of the index
+    //   Returns false if the value is negative or too large for an index
+    static bool toIndex(double v, GLuint &index) {
+        if (!(v >= 0.0 && v < 4294967296.0)) {
+            return false;
+        }
+        index = static_cast<GLuint>(v);
+        return true;
+    }
+
+    // Split a polygon into a fan of triangles around the first corner
+    //   polygon: Indices of the corners
+    //   out    : Storage location of the indices of the triangles
+    static void fan(const std::vector<GLuint> &polygon, std::vector<GLuint> &out) {
+        for (std::size_t k = 2; k < polygon.size(); ++k) {
+            out.insert(out.end(), {polygon[0], polygon[k - 1], polygon[k]});
+        }
+    }
+
+    // Give the vertices without a normal the normalized sum of the normals of the triangles around them, weighted by
+    // their areas
+    void computeNormals() {
+        std::vector<std::uint8_t> missing(vertex.size());
+        for (std::size_t k = 0; k < vertex.size(); ++k) {
+            const GLfloat *const n(vertex[k].normal);
+            missing[k] = n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f;
+        }
+        for (std::size_t t = 0; t + 2 < index.size(); t += 3) {
+            const GLfloat *const a(vertex[index[t]].position), *const b(vertex[index[t + 1]].position),
+                *const c(vertex[index[t + 2]].position);
+            const GLfloat u[3]{b[0] - a[0], b[1] - a[1], b[2] - a[2]}, v[3]{c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            const GLfloat n[3]{u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+            for (std::size_t k = t; k < t + 3; ++k) {
+                if (missing[index[k]]) {
+                    for (int i = 0; i < 3; ++i) {
+                        vertex[index[k]].normal[i] += n[i];
+                    }
+                }
+            }
+        }
+        parallel((vertex.size() + pieceLines - 1) / pieceLines, [&](std::size_t piece) {
+            const std::size_t last(std::min(vertex.size(), (piece + 1) * pieceLines));
+            for (std::size_t k = piece * pieceLines; k < last; ++k) {
+                GLfloat *const n(vertex[k].normal);
+                const GLfloat l(std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+                if (missing[k] && l > 0.0f) {
+                    for (int i = 0; i < 3; ++i) {
+                        n[i] /= l;
+                    }
+                }
+            }
+        });
+    }
+
+    // Find the box around the positions
+    void computeBounds() {
+        for (int i = 0; i < 3; ++i) {
+            lower[i] = vertex.empty() ? 0.0f : INFINITY;
+            upper[i] = vertex.empty() ? 0.0f : -INFINITY;
+        }
+        for (const Object::Vertex &v : vertex) {
+            for (int i = 0; i < 3; ++i) {
+                lower[i] = std::min(lower[i], v.position[i]);
+                upper[i] = std::max(upper[i], v.position[i]);
+            }
+        }
+    }
+};
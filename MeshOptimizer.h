@@ -0,0 +1,219 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Drawing objects
+#include "Object.h"
+
+// Reordering of the triangles and the vertices of a mesh before it is uploaded
+//   The triangles are ordered for the cache of transformed vertices with Tipsify (Sander, Nehab and Barczak, "Fast
+//   Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007), which fans around a vertex and moves on to a
+//   vertex still in the cache. The vertices are then ordered by their first use, so that the vertex fetch reads the
+//   vertex buffer object mostly forward. The triangles can also be joined into strips separated by the primitive
+//   restart index. The average cache miss ratio, the number of vertices transformed for each triangle, is found with a
+//   FIFO cache like the ones of most GPUs
+class MeshOptimizer {
+  public:
+    // Number of entries of the cache of transformed vertices
+    static constexpr unsigned cacheSize = 16;
+
+    // Index restarting a strip
+    static constexpr GLuint restart = 0xffffffffu;
+
+    // Order the triangles for the cache of transformed vertices
+    //   index      : Indices of the triangles, reordered in place
+    //   vertexcount: Number of vertices
+    static void optimizeCache(std::vector<GLuint> &index, std::size_t vertexcount) {
+        const std::size_t triangles(index.size() / 3);
+        if (triangles == 0) {
+            return;
+        }
+
+        // Triangles around each vertex and the number of them not emitted yet
+        std::vector<std::uint32_t> start(vertexcount + 1), live(vertexcount);
+        for (std::size_t k = 0; k < triangles * 3; ++k) {
+            ++live[index[k]];
+        }
+        for (std::size_t v = 0; v < vertexcount; ++v) {
+            start[v + 1] = start[v] + live[v];
+        }
+        std::vector<std::uint32_t> around(start[vertexcount]), fill(start.begin(), start.end() - 1);
+        for (std::size_t k = 0; k < triangles * 3; ++k) {
+            around[fill[index[k]]++] = static_cast<std::uint32_t>(k / 3);
+        }
+
+        // Time each vertex entered the cache, vertices of the last triangles, and the triangles emitted
+        std::vector<std::uint32_t> time(vertexcount), deadEnd;
+        std::vector<std::uint8_t> emitted(triangles);
+        std::vector<GLuint> out;
+        out.reserve(triangles * 3);
+        std::uint32_t now(cacheSize + 1);
+        std::size_t cursor(0);
+        std::vector<std::uint32_t> candidate;
+
+        for (std::int64_t fan = index[0]; fan >= 0;) {
+            // Emit every triangle left around the vertex
+            candidate.clear();
+            for (std::uint32_t a = start[fan]; a < start[fan + 1]; ++a) {
+                const std::uint32_t t(around[a]);
+                if (emitted[t]) {
+                    continue;
+                }
+                emitted[t] = 1;
+                for (std::size_t c = 3 * t; c < 3 * t + 3; ++c) {
+                    const GLuint v(index[c]);
+                    out.push_back(v);
+                    deadEnd.push_back(v);
+                    candidate.push_back(v);
+                    --live[v];
+                    if (now - time[v] > cacheSize) {
+                        time[v] = now++;
+                    }
+                }
+            }
+
+            // The candidate most recently cached that would stay in the cache while its triangles are emitted
+            fan = -1;
+            std::int64_t best(-1);
+            for (const std::uint32_t v : candidate) {
+                if (live[v] == 0) {
+                    continue;
+                }
+                std::int64_t priority(0);
+                if (now - time[v] + 2 * live[v] <= cacheSize) {
+                    priority = now - time[v];
+                }
+                if (priority > best) {
+                    best = priority;
+                    fan = v;
+                }
+            }
+
+            // At a dead end, a vertex of the last triangles that still has some, or else the next one in order
+            while (fan < 0 && !deadEnd.empty()) {
+                const std::uint32_t v(deadEnd.back());
+                deadEnd.pop_back();
+                if (live[v] > 0) {
+                    fan = v;
+                }
+            }
+            for (; fan < 0 && cursor < vertexcount; ++cursor) {
+                if (live[cursor] > 0) {
+                    fan = static_cast<std::int64_t>(cursor);
+                }
+            }
+        }
+        std::copy(out.begin(), out.end(), index.begin());
+    }
+
+    // Order the vertices by their first use and leave out the unused ones
+    //   vertex: Vertex attributes, reordered in place
+    //   index : Indices of the triangles, renumbered in place
+    static void optimizeFetch(std::vector<Object::Vertex> &vertex, std::vector<GLuint> &index) {
+        std::vector<GLuint> remap(vertex.size(), restart);
+        std::vector<Object::Vertex> out;
+        out.reserve(vertex.size());
+        for (GLuint &i : index) {
+            if (remap[i] == restart) {
+                remap[i] = static_cast<GLuint>(out.size());
+                out.push_back(vertex[i]);
+            }
+            i = remap[i];
+        }
+        vertex.swap(out);
+    }
+
+    // Average cache miss ratio, the number of vertices transformed for each triangle
+    //   index      : Indices of the triangles
+    //   vertexcount: Number of vertices
+    static double getAcmr(const std::vector<GLuint> &index, std::size_t vertexcount) {
+        if (index.size() < 3) {
+            return 0.0;
+        }
+
+        // A vertex is in the FIFO cache while fewer than its size have entered after it
+        std::vector<std::uint32_t> time(vertexcount);
+        std::uint32_t now(cacheSize + 1), misses(0);
+        for (const GLuint v : index) {
+            if (now - time[v] > cacheSize) {
+                time[v] = now++;
+                ++misses;
+            }
+        }
+        return static_cast<double>(misses) / static_cast<double>(index.size() / 3);
+    }
+
+    // Join triangles into strips separated by the restart index
+    //   Each strip is extended with a triangle sharing its last edge in the same winding among the next few triangles
+    //   index: Indices of the triangles
+    //   Returns the indices of the strips
+    static std::vector<GLuint> stripify(const std::vector<GLuint> &index) {
+        // Triangles waiting in the order they are given
+        constexpr std::size_t window(16);
+        std::vector<GLuint> waiting;
+        std::size_t next(0);
+
+        // Third vertex of a waiting triangle with the directed edge from a to b, or restart if none
+        const auto follow([&](std::size_t t, GLuint a, GLuint b) {
+            for (std::size_t c = 0; c < 3; ++c) {
+                if (waiting[3 * t + c] == a && waiting[3 * t + (c + 1) % 3] == b) {
+                    return waiting[3 * t + (c + 2) % 3];
+                }
+            }
+            return restart;
+        });
+        const auto find([&](GLuint a, GLuint b, GLuint &c) {
+            for (std::size_t t = 0; t < waiting.size() / 3; ++t) {
+                if ((c = follow(t, a, b)) != restart) {
+                    return t;
+                }
+            }
+            return waiting.size();
+        });
+        const auto remove([&](std::size_t t) { waiting.erase(waiting.begin() + 3 * t, waiting.begin() + 3 * t + 3); });
+
+        std::vector<GLuint> strip;
+        strip.reserve(index.size());
+        std::size_t length(0);
+        for (;;) {
+            while (waiting.size() < 3 * window && next + 2 < index.size()) {
+                waiting.insert(waiting.end(), &index[next], &index[next] + 3);
+                next += 3;
+            }
+            if (waiting.empty()) {
+                break;
+            }
+
+            // Extend the strip, whose triangles alternate their winding
+            if (length >= 3) {
+                const GLuint a(strip[strip.size() - 2]), b(strip.back());
+                GLuint c;
+                const std::size_t t(length % 2 == 0 ? find(a, b, c) : find(b, a, c));
+                if (t < waiting.size()) {
+                    strip.push_back(c);
+                    ++length;
+                    remove(t);
+                    continue;
+                }
+                strip.push_back(restart);
+            }
+
+            // Start a strip with the first waiting triangle, turned so that another one follows its last edge
+            GLuint v[3]{waiting[0], waiting[1], waiting[2]};
+            remove(0);
+            for (int r = 0; r < 3; ++r) {
+                GLuint c;
+                if (find(v[2], v[1], c) < waiting.size()) {
+                    break;
+                }
+                std::rotate(v, v + 1, v + 3);
+            }
+            strip.insert(strip.end(), v, v + 3);
+            length = 3;
+        }
+        return strip;
+    }
+};
@@ -1,5 +1,15 @@
 #pragma once
 #include <GL/glew.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Cache of the OpenGL state
+#include "GlState.h"
+
+// Layout of the vertex attributes
+#include "VertexLayout.h"
 
 class Object {
     // Vertex array object name
@@ -11,6 +21,9 @@ class Object {
     // Index vertex buffer object
     GLuint ibo{};
 
+    // Buffer object of the values restoring the vertex attributes
+    GLuint dbo{};
+
   public:
     // Vertex attribute
     struct Vertex {
@@ -21,40 +34,122 @@ class Object {
         GLfloat normal[3];
     };
 
+    // Function writing the vertex attributes and the indices into the storage of the buffer objects
+    using Fill = std::function<void(Vertex *vertex, GLuint *index)>;
+
     // Constructor
     //   size       : Dimension of the vertex position
     //   vertexcount: Number of vertices
     //   vertex     : Array containing the vertex attributes
     //   indexcount : Number of elements at the vertex index
     //   index      : Array containing the indices of the vertices
+    //   layout     : Layout of the vertex attributes in the buffer object, quantized from vertex when compact
     Object(GLint size, GLsizei vertexcount, const Vertex *vertex, GLsizei indexcount = 0,
-           const GLuint *index = nullptr) {
+           const GLuint *index = nullptr, const VertexLayout &layout = VertexLayout()) {
         // Vertex array object
         glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
+        GlState::bindVertexArray(vao);
+
+        // Values restoring the vertex attributes, the same for every vertex and instance, kept in a buffer object of
+        // the vertex array object even for a float layout, since the current values of the attributes are shared by
+        // every vertex array object of the context
+        const VertexLayout::Decode decode(layout.getDecode(vertex, vertex != nullptr ? vertexcount : 0));
+        glGenBuffers(1, &dbo);
+        GlState::bindBuffer(GL_ARRAY_BUFFER, dbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof decode, &decode, GL_STATIC_DRAW);
+        for (GLuint i = 0; i < 2; ++i) {
+            glVertexAttribPointer(VertexLayout::decodeLocation + i, 4, GL_FLOAT, GL_FALSE, 0,
+                                  i > 0 ? static_cast<const VertexLayout::Decode *>(nullptr)->offset : nullptr);
+            glVertexAttribDivisor(VertexLayout::decodeLocation + i, ~0u);
+            glEnableVertexAttribArray(VertexLayout::decodeLocation + i);
+        }
 
         // Vertex buffer object
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertexcount * sizeof(Vertex), vertex, GL_STATIC_DRAW);
+        GlState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+        const GLsizeiptr vertexsize(static_cast<GLsizeiptr>(vertexcount) * layout.getStride());
+        if (layout.isFloat() || vertex == nullptr) {
+            glBufferData(GL_ARRAY_BUFFER, vertexsize, vertex, GL_STATIC_DRAW);
+        } else {
+            std::vector<unsigned char> data(static_cast<std::size_t>(vertexsize));
+            layout.quantize(vertex, vertexcount, decode, data.data());
+            glBufferData(GL_ARRAY_BUFFER, vertexsize, data.data(), GL_STATIC_DRAW);
+        }
 
         // Allow bound vertex buffer object to be reference from the in-variable
-        glVertexAttribPointer(0, size, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<Vertex *>(nullptr)->position);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<Vertex *>(nullptr)->normal);
-        glEnableVertexAttribArray(1);
+        layout.setup(size);
 
-        // Index vertex buffer object
+        // Index vertex buffer object, narrowed to 16 bits when the vertices are few enough
         glGenBuffers(1, &ibo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexcount * sizeof(GLuint), index, GL_STATIC_DRAW);
+        GlState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        const GLsizeiptr indexsize(static_cast<GLsizeiptr>(indexcount) * getIndexSize(vertexcount));
+        if (getIndexType(vertexcount) == GL_UNSIGNED_INT || index == nullptr) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexsize, index, GL_STATIC_DRAW);
+        } else {
+            const std::vector<GLushort> narrow(index, index + indexcount);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexsize, narrow.data(), GL_STATIC_DRAW);
+        }
+    }
+
+    // Constructor of an object without vertex attributes
+    //   The vertex shader generates the vertices, so only the vertex array object is created
+    Object() { glGenVertexArrays(1, &vao); }
+
+    // Constructor filling the buffer objects in place
+    //   The storage is mapped and written directly, without an intermediate copy of the data
+    //   size       : Dimension of the vertex position
+    //   vertexcount: Number of vertices
+    //   indexcount : Number of elements at the vertex index
+    //   fill       : Function writing vertexcount vertex attributes and indexcount indices
+    //   layout     : Layout of the vertex attributes in the buffer object, compact ones written through a copy
+    Object(GLint size, GLsizei vertexcount, GLsizei indexcount, const Fill &fill,
+           const VertexLayout &layout = VertexLayout())
+        : Object(size, vertexcount, nullptr, indexcount, nullptr, layout) {
+        // Both buffer objects are still bound
+        const GLsizeiptr vertexsize(static_cast<GLsizeiptr>(vertexcount) * layout.getStride());
+        void *const storage(vertexcount > 0 ? glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexsize,
+                                                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)
+                                            : nullptr);
+        void *const indexStorage(indexcount > 0 ? glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0,
+                                                                   static_cast<GLsizeiptr>(indexcount) *
+                                                                       getIndexSize(vertexcount),
+                                                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)
+                                                : nullptr);
+
+        // 16-bit indices are narrowed from a copy
+        const bool narrow(getIndexType(vertexcount) == GL_UNSIGNED_SHORT);
+        std::vector<GLuint> wide(narrow ? indexcount : 0);
+        GLuint *const index(narrow ? wide.data() : static_cast<GLuint *>(indexStorage));
+        if (layout.isFloat()) {
+            fill(static_cast<Vertex *>(storage), index);
+        } else {
+            // The attributes are quantized into the storage after the box around them is known
+            std::vector<Vertex> vertex(vertexcount);
+            fill(vertex.data(), index);
+            const VertexLayout::Decode decode(layout.getDecode(vertex.data(), vertex.size()));
+            if (storage != nullptr) {
+                layout.quantize(vertex.data(), vertex.size(), decode, storage);
+            }
+            GlState::bindBuffer(GL_ARRAY_BUFFER, dbo);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof decode, &decode);
+            GlState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+        }
+        if (narrow && indexStorage != nullptr) {
+            std::copy(wide.begin(), wide.end(), static_cast<GLushort *>(indexStorage));
+        }
+
+        // The contents are lost if the storage was corrupted while mapped
+        if ((storage != nullptr && glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) ||
+            (indexStorage != nullptr && glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_FALSE)) {
+            std::cerr << "Error: Vertex data was lost while mapped" << std::endl;
+        }
     }
 
     // Destructor
     virtual ~Object() {
-        glDeleteVertexArrays(1, &vao);
-        glDeleteBuffers(1, &vbo);
-        glDeleteBuffers(1, &ibo);
+        GlState::deleteVertexArray(vao);
+        const GLuint buffers[] = {vbo, ibo, dbo};
+        GlState::deleteBuffers(3, buffers);
     }
 
   private:
@@ -65,9 +160,21 @@ class Object {
     Object &operator=(const Object &o);
 
   public:
+    // Type of the indices of a number of vertices, 16 bits while the restart index 0xffff stays unused
+    //   vertexcount: Number of vertices
+    static GLenum getIndexType(GLsizei vertexcount) {
+        return vertexcount < 0xffff ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    // Number of bytes of an index of a number of vertices
+    //   vertexcount: Number of vertices
+    static GLsizei getIndexSize(GLsizei vertexcount) {
+        return getIndexType(vertexcount) == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    }
+
     // Merging of vertex array objects
     void bind() const {
         // Specifies vertex array objects to be drawn
-        glBindVertexArray(vao);
+        GlState::bindVertexArray(vao);
     }
 };
\ No newline at end of file
@@ -0,0 +1,348 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Drawing objects
+#include "Object.h"
+
+// Pool of worker threads
+#include "JobSystem.h"
+
+// Transformation matrix
+#include "Matrix.h"
+
+// Transformation of vectors
+#include "Vector.h"
+
+// Structure-of-arrays vectors
+#include "VectorArray.h"
+
+// SIMD operations
+#include "Simd.h"
+
+// Low resolution depth buffer of occluders rasterized on the CPU for occlusion culling
+//   Low polygon occluders that lie inside the objects they stand for are rasterized four pixels at a time on several
+//   threads, and a pyramid of the farthest depths is built from the result. A bounding sphere is hidden when its
+//   nearest depth is behind the farthest occluder depth over the rectangle it covers, which only needs a few texels of
+//   the level whose texels are about as large as the rectangle. A pixel on the outline of an occluder is only covered
+//   when the occluder covers all of it, and every pixel takes the farthest depth of the triangle over it, so an object
+//   is not culled while any part of it may show past the occluder
+class OcclusionBuffer {
+    // Triangle set up for rasterizing
+    struct Triangle {
+        // Bounding rectangle in pixels, the upper bounds excluded
+        int x0, y0, x1, y1;
+        // Edge functions a x + b y + c at the corner of a pixel nearest the edge, positive when all of it is inside
+        GLfloat a[3], b[3], c[3];
+        // Depth plane at the corner of a pixel farthest away
+        GLfloat za, zb, zc;
+    };
+
+    // Level of the pyramid
+    struct Level {
+        // Size in texels
+        int width, height;
+        // Farthest depth in the normalized device coordinate system of the texels
+        std::vector<GLfloat> depth;
+    };
+
+    // Number of rows rasterized by a thread at a time
+    static constexpr int band = 8;
+
+    // Levels from the depth buffer, whose width is a multiple of 4
+    std::vector<Level> levels;
+
+    // Worker threads rasterizing the bands of rows
+    JobSystem *jobs{};
+
+    // Projection times view transformation matrix of the frame
+    Matrix viewProjection;
+
+    // Triangles of the occluders of the frame
+    std::vector<Triangle> triangles;
+
+    // Edge of a triangle of the occluder being added
+    struct Edge {
+        // Ends in 1/256 pixels, the lesser one first, so that the triangles on either side make the same key
+        std::array<std::int32_t, 4> key;
+        // Index of the triangle and the vertex opposite the edge
+        std::size_t triangle;
+        int side;
+    };
+
+    // Edges of the triangles of the occluder being added
+    std::vector<Edge> edges;
+
+  public:
+    // Constructor
+    //   width, height: Size of the depth buffer in pixels, the width is rounded up to a multiple of 4
+    explicit OcclusionBuffer(int width = 256, int height = 128) {
+        levels.push_back({(std::max(width, 4) + 3) & ~3, std::max(height, 1), {}});
+        while (levels.back().width > 1 || levels.back().height > 1) {
+            const Level &l(levels.back());
+            levels.push_back({(l.width + 1) / 2, (l.height + 1) / 2, {}});
+        }
+        for (Level &l : levels) {
+            l.depth.resize(static_cast<std::size_t>(l.width) * l.height);
+        }
+    }
+
+    // Destructor
+    virtual ~OcclusionBuffer() = default;
+
+    // Copy prohibition
+    OcclusionBuffer(const OcclusionBuffer &) = delete;
+    OcclusionBuffer &operator=(const OcclusionBuffer &) = delete;
+
+    // Rasterize on the threads of a pool, which must be set before render()
+    //   pool: Pool of worker threads
+    void setJobSystem(JobSystem *pool) { jobs = pool; }
+
+    // Number of triangles of the occluders of the frame that face the viewpoint
+    [[nodiscard]] std::size_t getTriangleCount() const { return triangles.size(); }
+
+    // Start a frame without occluders
+    //   viewProjection: Projection transformation matrix multiplied by the view transformation matrix
+    void begin(const Matrix &viewProjection) {
+        this->viewProjection = viewProjection;
+        triangles.clear();
+    }
+
+    // Add an occluder
+    //   Triangles facing away or crossing the near plane are left out, which only lets more objects pass
+    //   model     : Model transformation matrix of the occluder
+    //   vertex    : Vertex attributes of the occluder, which must lie inside the object
+    //   index     : Indices of the triangles of the occluder
+    //   indexcount: Number of indices
+    template <typename Kind>
+    void addOccluder(const BasicMatrix<Kind> &model, const Object::Vertex *vertex, const GLuint *index,
+                     std::size_t indexcount) {
+        const Matrix m(viewProjection * model);
+        const Level &l(levels[0]);
+        const GLfloat sx(0.5f * l.width), sy(0.5f * l.height);
+        edges.clear();
+        for (std::size_t i = 0; i + 2 < indexcount; i += 3) {
+            // Vertices in pixels and their depths
+            GLfloat x[3], y[3], z[3];
+            bool clipped(false);
+            for (int j = 0; j < 3; ++j) {
+                const GLfloat *const p(vertex[index[i + j]].position);
+                const Vector v(m * Vector{p[0], p[1], p[2], 1.0f});
+                if (v[2] < -v[3]) {
+                    clipped = true;
+                    break;
+                }
+                x[j] = (v[0] / v[3] + 1.0f) * sx;
+                y[j] = (v[1] / v[3] + 1.0f) * sy;
+                z[j] = v[2] / v[3];
+            }
+            if (clipped) {
+                continue;
+            }
+
+            // Twice the area, positive for the front face
+            const GLfloat area((x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]));
+            if (!(area > 0.0f)) {
+                continue;
+            }
+
+            // Pixels that may be covered
+            Triangle t;
+            t.x0 = std::max(static_cast<int>(std::floor(std::min({x[0], x[1], x[2]}))), 0);
+            t.y0 = std::max(static_cast<int>(std::floor(std::min({y[0], y[1], y[2]}))), 0);
+            t.x1 = std::min(static_cast<int>(std::ceil(std::max({x[0], x[1], x[2]}))), l.width);
+            t.y1 = std::min(static_cast<int>(std::ceil(std::max({y[0], y[1], y[2]}))), l.height);
+            if (t.x0 >= t.x1 || t.y0 >= t.y1) {
+                continue;
+            }
+
+            // Edge functions opposite each vertex, which are also its barycentric weight times the area
+            t.za = t.zb = t.zc = 0.0f;
+            for (int j = 0; j < 3; ++j) {
+                const int p((j + 1) % 3), q((j + 2) % 3);
+                t.a[j] = y[p] - y[q];
+                t.b[j] = x[q] - x[p];
+                t.c[j] = x[p] * y[q] - y[p] * x[q];
+                t.za += t.a[j] * z[j] / area;
+                t.zb += t.b[j] * z[j] / area;
+                t.zc += t.c[j] * z[j] / area;
+            }
+
+            // The rasterizer samples the centers of the pixels, which are half a pixel from the corners, for the depth
+            t.zc += 0.5f * (std::abs(t.za) + std::abs(t.zb));
+            for (int j = 0; j < 3; ++j) {
+                const int p((j + 1) % 3), q((j + 2) % 3);
+                std::array<std::int32_t, 4> key{static_cast<std::int32_t>(std::lround(x[p] * 256.0f)),
+                                                static_cast<std::int32_t>(std::lround(y[p] * 256.0f)),
+                                                static_cast<std::int32_t>(std::lround(x[q] * 256.0f)),
+                                                static_cast<std::int32_t>(std::lround(y[q] * 256.0f))};
+                if (std::make_pair(key[2], key[3]) < std::make_pair(key[0], key[1])) {
+                    std::swap(key[0], key[2]);
+                    std::swap(key[1], key[3]);
+                }
+                edges.push_back({key, triangles.size(), j});
+            }
+            triangles.push_back(t);
+        }
+
+        // Move the edges on the outline of the occluder in by half a pixel each way, so that the pixels on them are
+        // only covered when all of them is inside, while the edges shared by two triangles sample the centers of the
+        // pixels, which leaves no gaps between the triangles
+        std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) { return a.key < b.key; });
+        for (std::size_t i = 0; i < edges.size();) {
+            std::size_t j(i + 1);
+            while (j < edges.size() && edges[j].key == edges[i].key) {
+                ++j;
+            }
+            if (j == i + 1) {
+                Triangle &t(triangles[edges[i].triangle]);
+                const int side(edges[i].side);
+                t.c[side] -= 0.5f * (std::abs(t.a[side]) + std::abs(t.b[side]));
+            }
+            i = j;
+        }
+    }
+
+    // Rasterize the occluders and build the pyramid
+    void render() {
+        Level &l(levels[0]);
+        const int bands((l.height + band - 1) / band);
+        // Bands of rows as jobs of the pool
+        jobs->parallelFor(bands, 1, [&](std::size_t begin, std::size_t end) {
+            for (int k = static_cast<int>(begin); k < static_cast<int>(end); ++k) {
+                rasterize(k * band, std::min(k * band + band, l.height));
+            }
+        });
+
+        // Each texel of a level keeps the farthest of the texels below it
+        for (std::size_t k = 1; k < levels.size(); ++k) {
+            const Level &s(levels[k - 1]);
+            Level &d(levels[k]);
+            for (int y = 0; y < d.height; ++y) {
+                const std::size_t y0(std::min(2 * y, s.height - 1)), y1(std::min(2 * y + 1, s.height - 1));
+                const GLfloat *const r0(&s.depth[y0 * s.width]), *const r1(&s.depth[y1 * s.width]);
+                for (int x = 0; x < d.width; ++x) {
+                    const int x0(std::min(2 * x, s.width - 1)), x1(std::min(2 * x + 1, s.width - 1));
+                    d.depth[static_cast<std::size_t>(y) * d.width + x] =
+                        std::max(std::max(r0[x0], r0[x1]), std::max(r1[x0], r1[x1]));
+                }
+            }
+        }
+    }
+
+    // Whether a bounding sphere may be visible
+    //   x, y, z: Center of the sphere in the world coordinate system
+    //   r      : Radius of the sphere
+    [[nodiscard]] bool test(GLfloat x, GLfloat y, GLfloat z, GLfloat r) const {
+        // Rectangle and nearest depth of the corners of the box around the sphere
+        GLfloat lower[] = {INFINITY, INFINITY, INFINITY}, upper[] = {-INFINITY, -INFINITY};
+        for (int i = 0; i < 8; ++i) {
+            const Vector v(viewProjection *
+                           Vector{i & 1 ? x + r : x - r, i & 2 ? y + r : y - r, i & 4 ? z + r : z - r, 1.0f});
+            if (v[2] < -v[3]) {
+                return true;
+            }
+            for (int j = 0; j < 3; ++j) {
+                lower[j] = std::min(lower[j], v[j] / v[3]);
+            }
+            for (int j = 0; j < 2; ++j) {
+                upper[j] = std::max(upper[j], v[j] / v[3]);
+            }
+        }
+
+        // Level on which the rectangle spans at most two texels each way
+        const Level &l0(levels[0]);
+        const GLfloat w((upper[0] - lower[0]) * 0.5f * l0.width), h((upper[1] - lower[1]) * 0.5f * l0.height);
+        std::size_t k(0);
+        while (k + 1 < levels.size() && (w > static_cast<GLfloat>(2 << k) || h > static_cast<GLfloat>(2 << k))) {
+            ++k;
+        }
+
+        // Farthest occluder depth over the rectangle
+        const Level &l(levels[k]);
+        const GLfloat sx(0.5f * l.width), sy(0.5f * l.height);
+        const int x0(std::clamp(static_cast<int>(std::floor((lower[0] + 1.0f) * sx)), 0, l.width - 1));
+        const int x1(std::clamp(static_cast<int>(std::floor((upper[0] + 1.0f) * sx)), 0, l.width - 1));
+        const int y0(std::clamp(static_cast<int>(std::floor((lower[1] + 1.0f) * sy)), 0, l.height - 1));
+        const int y1(std::clamp(static_cast<int>(std::floor((upper[1] + 1.0f) * sy)), 0, l.height - 1));
+        GLfloat farthest(-INFINITY);
+        for (int j = y0; j <= y1; ++j) {
+            for (int i = x0; i <= x1; ++i) {
+                farthest = std::max(farthest, l.depth[static_cast<std::size_t>(j) * l.width + i]);
+            }
+        }
+        return lower[2] <= farthest;
+    }
+
+    // Leave out the hidden ones of the bounding spheres
+    //   spheres: Centers of the spheres in x, y and z and radii in w
+    //   visible: Indices of the spheres to be tested, which are replaced by the ones that may be visible
+    //   count  : Number of indices
+    //   Returns the number of spheres that may be visible
+    std::size_t cull(ConstVectorSpan spheres, std::uint32_t *visible, std::size_t count) const {
+        std::size_t kept(0);
+        for (std::size_t v = 0; v < count; ++v) {
+            const std::uint32_t k(visible[v]);
+            if (test(spheres.x[k], spheres.y[k], spheres.z[k], spheres.w[k])) {
+                visible[kept++] = k;
+            }
+        }
+        return kept;
+    }
+
+  private:
+    // Rasterize the triangles over a band of rows of the depth buffer
+    //   y0, y1: First row and the row after the last one
+    void rasterize(int y0, int y1) {
+        Level &l(levels[0]);
+        std::fill(l.depth.begin() + static_cast<std::ptrdiff_t>(y0) * l.width,
+                  l.depth.begin() + static_cast<std::ptrdiff_t>(y1) * l.width, 1.0f);
+
+        // Centers of four pixels in a row
+        alignas(16) static constexpr GLfloat offset[] = {0.5f, 1.5f, 2.5f, 3.5f};
+        const simd::float4 centers(simd::load(offset));
+
+        for (const Triangle &t : triangles) {
+            const int top(std::min(t.y1, y1));
+            const int left(t.x0 & ~3);
+            const simd::float4 a0(simd::splat(t.a[0])), a1(simd::splat(t.a[1])), a2(simd::splat(t.a[2]));
+            const simd::float4 za(simd::splat(t.za));
+            for (int y = std::max(t.y0, y0); y < top; ++y) {
+                const GLfloat yc(static_cast<GLfloat>(y) + 0.5f);
+                const simd::float4 r0(simd::splat(t.b[0] * yc + t.c[0])), r1(simd::splat(t.b[1] * yc + t.c[1]));
+                const simd::float4 r2(simd::splat(t.b[2] * yc + t.c[2])), rz(simd::splat(t.zb * yc + t.zc));
+                GLfloat *const row(&l.depth[static_cast<std::size_t>(y) * l.width]);
+                for (int x = left; x < t.x1; x += 4) {
+                    // Pixels reaching out of any edge have a negative edge function
+                    const simd::float4 px(simd::add(simd::splat(static_cast<GLfloat>(x)), centers));
+                    const simd::float4 inside(simd::min(simd::madd(a0, px, r0),
+                                                        simd::min(simd::madd(a1, px, r1), simd::madd(a2, px, r2))));
+                    const int outside(simd::negative(inside));
+                    if (outside == 15) {
+                        continue;
+                    }
+
+                    // Keep the nearer depth, one pixel at a time only on the edges
+                    const simd::float4 z(simd::madd(za, px, rz));
+                    if (outside == 0) {
+                        simd::store(row + x, simd::min(simd::load(row + x), z));
+                    } else {
+                        alignas(16) GLfloat d[4];
+                        simd::store(d, z);
+                        for (int i = 0; i < 4; ++i) {
+                            if ((outside & (1 << i)) == 0) {
+                                row[x + i] = std::min(row[x + i], d[i]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+// Drawing shapes
+#include "Shape.h"
+
+// Sphere of radius 1 generated in the vertex shader without any vertex buffer
+//   The vertex shader compiled with PROCEDURAL derives the position and the normal of each vertex of the triangles
+//   from gl_VertexID and the uniform variable divisions, so the sphere takes no vertex memory and no upload
+class ProceduralSphere : public Shape {
+    // Number of divisions around and from pole to pole
+    const GLint slices, stacks;
+
+    // Program object of the last drawing and the location of its uniform variable divisions
+    mutable GLuint program{};
+    mutable GLint location{-1};
+
+  public:
+    // Constructor
+    //   slices: Number of divisions around the y axis
+    //   stacks: Number of divisions from the north pole to the south pole
+    ProceduralSphere(GLint slices, GLint stacks) : Shape(slices * stacks * 6), slices(slices), stacks(stacks) {}
+
+    // Execute drawing
+    void execute() const override {
+        setDivisions();
+        glDrawArrays(GL_TRIANGLES, 0, vertexcount);
+    }
+
+    // Execute instanced drawing
+    void executeInstanced(GLsizei count) const override {
+        setDivisions();
+        glDrawArraysInstanced(GL_TRIANGLES, 0, vertexcount, count);
+    }
+
+  private:
+    // Pass the numbers of divisions to the current program object, which is known without querying the context
+    void setDivisions() const {
+        const GLuint current(GlState::getProgram());
+        if (current != program) {
+            program = current;
+            location = glGetUniformLocation(program, "divisions");
+        }
+        GlState::uniform2i(location, slices, stacks);
+    }
+};
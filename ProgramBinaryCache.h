@@ -0,0 +1,228 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Cache of the OpenGL state
+#include "GlState.h"
+
+// CPU trace
+#include "Trace.h"
+
+// Persistent cache of linked program objects in the driver's binary format
+//   Each entry is a file named after the hash of the shader sources, with a header holding the hash of the driver
+//   identification and a checksum of the binary, so that entries of another driver, damaged files and binaries the
+//   driver refuses are all detected and rebuilt
+class ProgramBinaryCache {
+    // Header of a cache file
+    struct Header {
+        // File identification and format version
+        char magic[4];
+        std::uint32_t version;
+        // Hash of the shader sources
+        std::uint64_t key;
+        // Hash of the vendor, renderer and version strings of the driver
+        std::uint64_t driver;
+        // Checksum of the binary
+        std::uint64_t checksum;
+        // Format and length of the binary
+        std::uint32_t format;
+        std::uint32_t length;
+    };
+
+    // Version of the file format
+    static constexpr std::uint32_t fileVersion = 1;
+
+    // Directory of the cache files
+    std::filesystem::path directory;
+
+    // Hash of the driver identification
+    std::uint64_t driver{};
+
+    // Whether program binaries are supported
+    bool enabled{};
+
+    // Number of programs loaded from the cache, missing from it, and refused because their entries were stale or
+    // invalid
+    long hits{}, misses{}, rejected{};
+
+  public:
+    // Use counts of the cache
+    struct Stats {
+        long hits, misses, rejected;
+    };
+
+    // Constructor
+    //   directory: Directory of the cache files, created if it does not exist
+    explicit ProgramBinaryCache(const char *directory) : directory(directory) {
+        if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) {
+            return;
+        }
+        GLint formats(0);
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats == 0) {
+            return;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(this->directory, error);
+        if (error) {
+            std::cerr << "Error: Can't create program cache: " << directory << std::endl;
+            return;
+        }
+
+        // Binaries are only valid for the same driver
+        for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION}) {
+            const char *const s(reinterpret_cast<const char *>(glGetString(name)));
+            if (s != nullptr) {
+                driver = hash(s, std::char_traits<char>::length(s) + 1, driver);
+            }
+        }
+        enabled = true;
+    }
+
+    // Destructor
+    virtual ~ProgramBinaryCache() = default;
+
+    // Copy prohibition
+    ProgramBinaryCache(const ProgramBinaryCache &) = delete;
+    ProgramBinaryCache &operator=(const ProgramBinaryCache &) = delete;
+
+    // Whether the cache is used
+    explicit operator bool() const { return enabled; }
+
+    // Retrieve the use counts
+    [[nodiscard]] Stats getStats() const { return {hits, misses, rejected}; }
+
+    // 64-bit FNV-1a hash
+    //   data: Data to hash
+    //   size: Number of bytes
+    //   h   : Hash of the preceding data to continue from
+    static std::uint64_t hash(const void *data, std::size_t size, std::uint64_t h = 14695981039346656037ull) {
+        const unsigned char *const p(static_cast<const unsigned char *>(data));
+        for (std::size_t i = 0; i < size; ++i) {
+            h = (h ^ p[i]) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Key of a program object
+    //   vsrc: Vertex shader source program string, including the macro definitions
+    //   fsrc: Fragment shader source program string, including the macro definitions
+    static std::uint64_t key(const std::string &vsrc, const std::string &fsrc) {
+        return hash(fsrc.c_str(), fsrc.size() + 1, hash(vsrc.c_str(), vsrc.size() + 1));
+    }
+
+    // Create a program object from the cache
+    //   vsrc: Vertex shader source program string
+    //   fsrc: Fragment shader source program string
+    //   Returns 0 if there is no valid entry, and the program object must then be built and stored
+    GLuint load(const std::string &vsrc, const std::string &fsrc) {
+        if (!enabled) {
+            return 0;
+        }
+        TRACE_FUNCTION();
+
+        const std::uint64_t k(key(vsrc, fsrc));
+        std::ifstream file(path(k), std::ios::binary);
+        if (file.fail()) {
+            ++misses;
+            return 0;
+        }
+
+        // Check the header before reading the binary, whose length must be the rest of the file
+        file.seekg(0, std::ios::end);
+        const std::streamoff size(file.tellg());
+        file.seekg(0);
+        Header header;
+        file.read(reinterpret_cast<char *>(&header), sizeof header);
+        if (file.fail() || std::char_traits<char>::compare(header.magic, "GLPB", 4) != 0 ||
+            header.version != fileVersion || header.key != k || header.driver != driver ||
+            static_cast<std::streamoff>(header.length) != size - static_cast<std::streamoff>(sizeof header)) {
+            ++rejected;
+            return 0;
+        }
+        std::vector<char> binary(header.length);
+        file.read(binary.data(), header.length);
+        if (file.fail() || hash(binary.data(), binary.size()) != header.checksum) {
+            ++rejected;
+            return 0;
+        }
+
+        // The driver may still refuse a binary, for example after an update that kept the version string, and a format
+        // it does not support leaves an error behind
+        const GLuint program(glCreateProgram());
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.length));
+        GLint status;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status == GL_FALSE) {
+            while (glGetError() != GL_NO_ERROR) {
+            }
+            GlState::deleteProgram(program);
+            ++rejected;
+            return 0;
+        }
+
+        ++hits;
+        return program;
+    }
+
+    // Store a program object in the cache
+    //   The file is written under a temporary name and renamed, so a reader never sees a partial entry
+    //   program: Program object name linked from the sources
+    //   vsrc   : Vertex shader source program string
+    //   fsrc   : Fragment shader source program string
+    void store(GLuint program, const std::string &vsrc, const std::string &fsrc) const {
+        if (!enabled || program == 0) {
+            return;
+        }
+        TRACE_FUNCTION();
+
+        GLint length(0);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        std::vector<char> binary(length);
+        GLenum format;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+        binary.resize(length);
+
+        const std::uint64_t k(key(vsrc, fsrc));
+        const Header header{{'G', 'L', 'P', 'B'}, fileVersion, k, driver, hash(binary.data(), binary.size()),
+                            format, static_cast<std::uint32_t>(length)};
+        const std::filesystem::path name(path(k)), temporary(name.string() + ".tmp");
+        bool written;
+        {
+            std::ofstream file(temporary, std::ios::binary);
+            file.write(reinterpret_cast<const char *>(&header), sizeof header);
+            file.write(binary.data(), length);
+            file.close();
+            written = !file.fail();
+        }
+
+        // The temporary file is not left behind when it can't be written or renamed
+        std::error_code error;
+        if (!written) {
+            std::cerr << "Error: Can't write program cache: " << temporary.string() << std::endl;
+        } else {
+            std::filesystem::rename(temporary, name, error);
+        }
+        if (!written || error) {
+            std::filesystem::remove(temporary, error);
+        }
+    }
+
+  private:
+    // Path of the cache file of a key
+    //   k: Key of the program object
+    [[nodiscard]] std::filesystem::path path(std::uint64_t k) const {
+        char name[32];
+        std::snprintf(name, sizeof name, "%016llx.bin", static_cast<unsigned long long>(k));
+        return directory / name;
+    }
+};
@@ -0,0 +1,303 @@
+#pragma once
+#include <GL/glew.h>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Shader compilation
+#include "Shader.h"
+
+// Persistent cache of program binaries
+#include "ProgramBinaryCache.h"
+
+// Cache of the OpenGL state
+#include "GlState.h"
+
+// Program objects specialized by macro definitions injected into the shader sources
+//   Each variant is compiled and linked only when it is requested for the first time, and is kept until the cache is
+//   destroyed, so a drawing can use the smallest shader for its features instead of a generic one that branches.
+//   Requested variants are built in the background where the driver supports it, and their status is only queried
+//   when they are complete or needed
+class ProgramCache {
+  public:
+    // Macro definitions of a variant, ordered by name so that the same set always makes the same key
+    using Defines = std::map<std::string, std::string>;
+
+  private:
+    // Variant whose compilation and link have been submitted
+    struct Pending {
+        // Program object name
+        GLuint program;
+        // Specialized sources, kept to store the binary
+        std::string vsrc, fsrc;
+    };
+
+    // Loaded shader source files
+    std::map<std::string, std::vector<GLchar>> sources;
+
+    // Shader source files being read on other threads, empty when the file cannot be read
+    std::map<std::string, std::future<std::vector<GLchar>>> reading;
+
+    // Program objects of the variants by key
+    std::map<std::string, GLuint> programs;
+
+    // Variants being built by key
+    std::map<std::string, Pending> pending;
+
+    // Set up performed once on every new program object
+    std::function<void(GLuint)> initializer;
+
+    // Cache of the program binaries on disk
+    ProgramBinaryCache *binaries{};
+
+    // Time the calling thread spent building the variants or waiting for them
+    std::chrono::steady_clock::duration elapsed{};
+
+  public:
+    // Constructor
+    ProgramCache() {
+        // Let the driver use as many threads as it likes for compiling
+        if (GLEW_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xffffffffu);
+        }
+    }
+
+    // Destructor
+    virtual ~ProgramCache() {
+        for (const auto &p : pending) {
+            GlState::deleteProgram(p.second.program);
+        }
+        for (const auto &p : programs) {
+            GlState::deleteProgram(p.second);
+        }
+    }
+
+    // Copy prohibition
+    ProgramCache(const ProgramCache &) = delete;
+    ProgramCache &operator=(const ProgramCache &) = delete;
+
+    // Number of variants built
+    [[nodiscard]] std::size_t size() const { return programs.size(); }
+
+    // Start reading shader source files on other threads
+    //   names: Shader source file names
+    void prefetch(std::initializer_list<const char *> names) {
+        for (const char *const name : names) {
+            if (sources.count(name) == 0 && reading.count(name) == 0) {
+                reading.emplace(name, std::async(std::launch::async, [name] {
+                                    std::vector<GLchar> buffer;
+                                    return readShaderSource(name, buffer) ? buffer : std::vector<GLchar>();
+                                }));
+            }
+        }
+    }
+
+    // Set the set up of new program objects, such as connecting uniform blocks
+    //   f: Function called with the name of each program object linked successfully
+    void setInitializer(std::function<void(GLuint)> f) { initializer = std::move(f); }
+
+    // Load the variants from program binaries and store the ones built from the sources
+    //   cache: Cache of the program binaries, nullptr to always build from the sources
+    void setBinaryCache(ProgramBinaryCache *cache) { binaries = cache; }
+
+    // Print the number of variants and the time spent building them
+    //   os: Output stream
+    void report(std::ostream &os) const {
+        os << programs.size() << " programs in "
+           << std::chrono::duration<double, std::milli>(elapsed).count() << " ms";
+        if (binaries != nullptr && *binaries) {
+            const ProgramBinaryCache::Stats s(binaries->getStats());
+            os << " (" << s.hits << " from the binary cache, " << s.misses << " missing, " << s.rejected
+               << " rejected)";
+        }
+        os << '\n';
+    }
+
+    // Start building a variant without waiting for it
+    //   vert   : Vertex shader source file name
+    //   frag   : Source file name of the fragment shader
+    //   defines: Macro definitions of the variant
+    void request(const char *vert, const char *frag, const Defines &defines = {}) {
+        submit(key(vert, frag, defines), vert, frag, defines);
+    }
+
+    // Finish the variants whose build has completed, meant to be called once a frame
+    //   Returns the number of variants still being built
+    std::size_t poll() {
+        for (auto p = pending.begin(); p != pending.end();) {
+            if (isProgramComplete(p->second.program)) {
+                finish(p++);
+            } else {
+                ++p;
+            }
+        }
+        return pending.size();
+    }
+
+    // Retrieve a variant only if it is ready, without waiting for it
+    //   vert   : Vertex shader source file name
+    //   frag   : Source file name of the fragment shader
+    //   defines: Macro definitions of the variant
+    //   Returns 0 if the variant is still being built, has not been requested, or cannot be built
+    [[nodiscard]] GLuint find(const char *vert, const char *frag, const Defines &defines = {}) const {
+        const auto found(programs.find(key(vert, frag, defines)));
+        return found != programs.end() ? found->second : 0;
+    }
+
+    // Retrieve a variant, building it if it is requested for the first time
+    //   Waits for the variant if it is still being built
+    //   vert   : Vertex shader source file name
+    //   frag   : Source file name of the fragment shader
+    //   defines: Macro definitions of the variant
+    //   Returns 0 if the variant cannot be built, and does not retry it
+    GLuint get(const char *vert, const char *frag, const Defines &defines = {}) {
+        const std::string k(key(vert, frag, defines));
+        const auto found(programs.find(k));
+        if (found != programs.end()) {
+            return found->second;
+        }
+        submit(k, vert, frag, defines);
+        const auto p(pending.find(k));
+        return p != pending.end() ? finish(p) : programs[k];
+    }
+
+    // Key of a variant
+    //   vert   : Vertex shader source file name
+    //   frag   : Source file name of the fragment shader
+    //   defines: Macro definitions of the variant
+    static std::string key(const char *vert, const char *frag, const Defines &defines) {
+        std::string k(vert);
+        k += '+';
+        k += frag;
+        for (const auto &d : defines) {
+            k += ' ';
+            k += d.first;
+            if (!d.second.empty()) {
+                k += '=';
+                k += d.second;
+            }
+        }
+        return k;
+    }
+
+    // Insert macro definitions into a shader source
+    //   The definitions follow the #version line, which must come first, and a #line directive restores the line
+    //   numbers of the compilation errors
+    //   src    : Shader source program string
+    //   defines: Macro definitions
+    static std::string inject(const char *src, const Defines &defines) {
+        // Position after the #version line and its line number
+        const char *body(src);
+        int line(1);
+        if (std::strncmp(src + std::strspn(src, " \t\r\n"), "#version", 8) == 0) {
+            body = std::strstr(src, "#version");
+            body += std::strcspn(body, "\n");
+            if (*body == '\n') {
+                ++body;
+            }
+            for (const char *c = src; c < body; ++c) {
+                line += *c == '\n';
+            }
+        }
+
+        std::string s(src, body);
+        for (const auto &d : defines) {
+            s += "#define " + d.first + ' ' + d.second + '\n';
+        }
+        s += "#line " + std::to_string(line) + '\n';
+        return s + body;
+    }
+
+  private:
+    // Submit the build of a variant
+    //   A variant found in the binary cache, or whose sources cannot be read, is finished at once
+    //   k      : Key of the variant
+    //   vert   : Vertex shader source file name
+    //   frag   : Source file name of the fragment shader
+    //   defines: Macro definitions of the variant
+    void submit(const std::string &k, const char *vert, const char *frag, const Defines &defines) {
+        if (programs.count(k) != 0 || pending.count(k) != 0) {
+            return;
+        }
+
+        TRACE_SCOPE("submit program variant");
+        const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+        // Create program object from the specialized sources, unless its binary is in the cache
+        const std::vector<GLchar> *const vsrc(source(vert));
+        const std::vector<GLchar> *const fsrc(source(frag));
+        GLuint program(0);
+        if (vsrc != nullptr && fsrc != nullptr) {
+            std::string v(inject(vsrc->data(), defines)), f(inject(fsrc->data(), defines));
+            if (binaries != nullptr) {
+                program = binaries->load(v, f);
+            }
+            if (program == 0) {
+                const GLuint p(submitProgram(v.c_str(), f.c_str(), binaries != nullptr && *binaries));
+                pending.emplace(k, Pending{p, std::move(v), std::move(f)});
+                elapsed += std::chrono::steady_clock::now() - start;
+                return;
+            }
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+        add(k, program);
+    }
+
+    // Wait for a variant being built
+    //   p: Variant being built
+    //   Returns the program object, or 0 if it cannot be built
+    GLuint finish(std::map<std::string, Pending>::iterator p) {
+        TRACE_SCOPE("finish program variant");
+        const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+        const GLuint program(finishProgram(p->second.program));
+        if (binaries != nullptr) {
+            binaries->store(program, p->second.vsrc, p->second.fsrc);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        const std::string k(p->first);
+        pending.erase(p);
+        add(k, program);
+        return program;
+    }
+
+    // Keep a variant that is ready
+    //   k      : Key of the variant
+    //   program: Program object name, 0 if the variant cannot be built
+    void add(const std::string &k, GLuint program) {
+        if (program == 0) {
+            std::cerr << "Error: Can't build " << k << std::endl;
+        } else if (initializer) {
+            initializer(program);
+        }
+        programs.emplace(k, program);
+    }
+
+    // Load a shader source file only once
+    //   name: Shader source file name
+    //   Returns nullptr if the file cannot be read
+    const std::vector<GLchar> *source(const char *name) {
+        const auto found(sources.find(name));
+        if (found != sources.end()) {
+            return found->second.empty() ? nullptr : &found->second;
+        }
+
+        // Wait for the file if it is being read
+        std::vector<GLchar> buffer;
+        const auto read(reading.find(name));
+        if (read != reading.end()) {
+            buffer = read->second.get();
+            reading.erase(read);
+        } else if (!readShaderSource(name, buffer)) {
+            buffer.clear();
+        }
+        const std::vector<GLchar> &s(sources.emplace(name, std::move(buffer)).first->second);
+        return s.empty() ? nullptr : &s;
+    }
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pool of worker threads
+#include "JobSystem.h"
+
+// Transformation matrix
+#include "Matrix.h"
+
+// Hierarchy of rigid transformations kept in arrays of each property
+//   A node is added after its parent, and only the nodes whose transformation or ancestors have changed since the last
+//   update are recomputed with their subtrees, so the cost of a frame follows what moved. Changing the view
+//   transformation recomputes the model view transformations of every node. The world transformations are propagated
+//   down the hierarchy on one thread, and the model view and normal transformations of the nodes recomputed are then
+//   split across the threads of a pool
+class Scene {
+  public:
+    // Parent of a root node
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+  private:
+    // Transformations relative to the parents
+    std::vector<RigidMatrix> local;
+
+    // Model transformations in the world coordinate system
+    std::vector<RigidMatrix> world;
+
+    // Model view transformations
+    std::vector<RigidMatrix> modelview;
+
+    // Normal vector transformations, 9 elements for each node
+    std::vector<GLfloat> normal;
+
+    // Parent, first child and next sibling of the nodes
+    std::vector<std::uint32_t> parent, child, sibling;
+
+    // Whether the transformation of the node has changed
+    std::vector<std::uint8_t> dirty;
+
+    // Nodes whose transformations have changed
+    std::vector<std::uint32_t> changed;
+
+    // Nodes recomputed by the last update
+    std::vector<std::uint32_t> updated;
+
+    // View transformation
+    RigidMatrix view;
+
+    // Whether the view transformation has changed
+    bool viewDirty{true};
+
+    // Worker threads for the model view and normal transformations, none to compute them on the calling thread
+    JobSystem *jobs{};
+
+  public:
+    // Constructor
+    //   view: View transformation matrix
+    explicit Scene(const RigidMatrix &view = RigidMatrix::identity()) : view(view) {}
+
+    // Destructor
+    virtual ~Scene() = default;
+
+    // Copy prohibition
+    Scene(const Scene &) = delete;
+    Scene &operator=(const Scene &) = delete;
+
+    // Number of nodes
+    [[nodiscard]] std::size_t size() const { return local.size(); }
+
+    // Compute the model view and normal transformations on the threads of a pool
+    //   pool: Pool of worker threads, nullptr to compute them on the calling thread
+    void setJobSystem(JobSystem *pool) { jobs = pool; }
+
+    // Add a node
+    //   m         : Transformation relative to the parent
+    //   parentNode: Node added before, or none for a root
+    //   Returns the node
+    std::uint32_t add(const RigidMatrix &m, std::uint32_t parentNode = none) {
+        const std::uint32_t node(static_cast<std::uint32_t>(local.size()));
+        local.push_back(m);
+        world.emplace_back();
+        modelview.emplace_back();
+        normal.resize(normal.size() + 9);
+        parent.push_back(parentNode);
+        child.push_back(none);
+        sibling.push_back(none);
+        if (parentNode != none) {
+            sibling[node] = child[parentNode];
+            child[parentNode] = node;
+        }
+        dirty.push_back(1);
+        changed.push_back(node);
+        return node;
+    }
+
+    // Change the transformation of a node relative to its parent
+    //   node: Node
+    //   m   : Transformation relative to the parent
+    void setLocal(std::uint32_t node, const RigidMatrix &m) {
+        local[node] = m;
+        if (!dirty[node]) {
+            dirty[node] = 1;
+            changed.push_back(node);
+        }
+    }
+
+    // Change the view transformation
+    //   m: View transformation matrix
+    void setView(const RigidMatrix &m) {
+        view = m;
+        viewDirty = true;
+    }
+
+    // Recompute the changed nodes and their subtrees
+    //   Returns the number of nodes recomputed
+    std::size_t update() {
+        updated.clear();
+        if (viewDirty) {
+            // Every node in the order they were added, which puts the parents first
+            for (std::uint32_t node = 0; node < local.size(); ++node) {
+                propagate(node);
+                updated.push_back(node);
+            }
+            for (const std::uint32_t node : changed) {
+                dirty[node] = 0;
+            }
+            viewDirty = false;
+        } else {
+            // The ancestors go first, and a node already recomputed with them is left clean
+            std::sort(changed.begin(), changed.end());
+            std::vector<std::uint32_t> stack;
+            for (const std::uint32_t root : changed) {
+                if (!dirty[root]) {
+                    continue;
+                }
+                stack.push_back(root);
+                while (!stack.empty()) {
+                    const std::uint32_t node(stack.back());
+                    stack.pop_back();
+                    propagate(node);
+                    dirty[node] = 0;
+                    updated.push_back(node);
+                    for (std::uint32_t c = child[node]; c != none; c = sibling[c]) {
+                        stack.push_back(c);
+                    }
+                }
+            }
+        }
+        changed.clear();
+
+        // The nodes recomputed no longer depend on each other
+        if (jobs != nullptr) {
+            jobs->parallelFor(updated.size(), 1024, [this](std::size_t begin, std::size_t end) {
+                for (std::size_t k = begin; k < end; ++k) {
+                    transform(updated[k]);
+                }
+            });
+        } else {
+            for (const std::uint32_t node : updated) {
+                transform(node);
+            }
+        }
+        return updated.size();
+    }
+
+    // Nodes recomputed by the last update
+    [[nodiscard]] const std::vector<std::uint32_t> &getUpdated() const { return updated; }
+
+    // Retrieve the model transformation of a node in the world coordinate system
+    [[nodiscard]] const RigidMatrix &getWorld(std::uint32_t node) const { return world[node]; }
+
+    // Retrieve the model view transformation of a node
+    [[nodiscard]] const RigidMatrix &getModelview(std::uint32_t node) const { return modelview[node]; }
+
+    // Retrieve the normal vector transformation of a node, 9 elements
+    [[nodiscard]] const GLfloat *getNormalMatrix(std::uint32_t node) const { return &normal[9 * node]; }
+
+  private:
+    // Compute the model transformation of a node from the one of its parent
+    //   node: Node
+    void propagate(std::uint32_t node) {
+        const std::uint32_t p(parent[node]);
+        world[node] = p == none ? local[node] : world[p] * local[node];
+    }
+
+    // Compute the model view and normal transformations of a node from its model transformation
+    //   node: Node
+    void transform(std::uint32_t node) {
+        modelview[node] = view * world[node];
+        modelview[node].getNormalMatrix(&normal[9 * node]);
+    }
+};
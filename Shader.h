@@ -0,0 +1,212 @@
+#pragma once
+#include <GL/glew.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Cache of the OpenGL state
+#include "GlState.h"
+
+// CPU trace
+#include "Trace.h"
+
+// Display the compiled result of shader object
+//   shader: Shader object name
+//   str   : String indicating where the compilation error occurred
+inline GLboolean printShaderInfoLog(GLuint shader, const char *str) {
+    // Get compilation result
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE) {
+        std::cerr << "Compile Error in " << str << std::endl;
+    }
+
+    // Get log length when shader is compiled
+    GLsizei bufSize;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &bufSize);
+
+    if (bufSize > 1) {
+        // Get log contents
+        std::vector<GLchar> infoLog(bufSize);
+        GLsizei length;
+        glGetShaderInfoLog(shader, bufSize, &length, &infoLog[0]);
+        std::cerr << &infoLog[0] << std::endl;
+    }
+
+    return static_cast<GLboolean>(status);
+}
+
+// Display the link result of program object
+//   program: program object name
+inline GLboolean printProgramInfoLog(GLuint program) {
+    // Get link result
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        std::cerr << "Link Error." << std::endl;
+    }
+
+    // Get log length when linking shader
+    GLsizei bufSize;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &bufSize);
+
+    if (bufSize > 1) {
+        // Get log contents
+        std::vector<GLchar> infoLog(bufSize);
+        GLsizei length;
+        glGetProgramInfoLog(program, bufSize, &length, &infoLog[0]);
+        std::cerr << &infoLog[0] << std::endl;
+    }
+
+    return static_cast<GLboolean>(status);
+}
+
+// Start building a program object without waiting for the result
+//   Neither the compilation nor the link status is queried here, so the driver may build several program objects in
+//   parallel until finishProgram() is called
+//   vsrc       : Vertex shader source program string
+//   fsrc       : Fragment shader source program string
+//   retrievable: Whether the binary of the program object will be retrieved
+inline GLuint submitProgram(const char *vsrc, const char *fsrc, bool retrievable = false) {
+    TRACE_FUNCTION();
+
+    // Create empty object
+    const GLuint program(glCreateProgram());
+
+    if (vsrc != nullptr) {
+        TRACE_SCOPE("compile vertex shader");
+
+        // Create shader object for vertex shader
+        const GLuint vobj(glCreateShader(GL_VERTEX_SHADER));
+        glShaderSource(vobj, 1, &vsrc, nullptr);
+        glCompileShader(vobj);
+
+        // Embed shader object of vertex shader into program object, it is deleted when detached
+        glAttachShader(program, vobj);
+        glDeleteShader(vobj);
+    }
+
+    if (fsrc != nullptr) {
+        TRACE_SCOPE("compile fragment shader");
+
+        // Create shader object for fragment shader
+        const GLuint fobj(glCreateShader(GL_FRAGMENT_SHADER));
+        glShaderSource(fobj, 1, &fsrc, nullptr);
+        glCompileShader(fobj);
+
+        // Embed shader object of fragment shader into program object, it is deleted when detached
+        glAttachShader(program, fobj);
+        glDeleteShader(fobj);
+    }
+
+    // Link program object
+    glBindAttribLocation(program, 0, "vertexPosition");
+    glBindAttribLocation(program, 1, "vertexNormal");
+    glBindFragDataLocation(program, 0, "fragment");
+    if (retrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+// Whether a program object submitted by submitProgram() can be finished without waiting
+//   Always true without KHR_parallel_shader_compile
+//   program: Program object name
+inline bool isProgramComplete(GLuint program) {
+    if (!GLEW_KHR_parallel_shader_compile) {
+        return true;
+    }
+    GLint complete;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete != GL_FALSE;
+}
+
+// Wait for a program object submitted by submitProgram() and display the results
+//   program: Program object name
+//   Returns the program object, or 0 after deleting it if it cannot be created
+inline GLuint finishProgram(GLuint program) {
+    TRACE_FUNCTION();
+
+    // Display the compiled results of the shader objects and release them
+    GLuint shader[2];
+    GLsizei count;
+    glGetAttachedShaders(program, 2, &count, shader);
+    for (GLsizei i = 0; i < count; ++i) {
+        GLint type;
+        glGetShaderiv(shader[i], GL_SHADER_TYPE, &type);
+        printShaderInfoLog(shader[i], type == GL_VERTEX_SHADER ? "vertex shader" : "fragment shader");
+        glDetachShader(program, shader[i]);
+    }
+
+    // Return created program object
+    if (printProgramInfoLog(program)) {
+        return program;
+    }
+
+    // Return 0, if program object cannot be created
+    GlState::deleteProgram(program);
+    return 0;
+}
+
+// Create program object
+//   vsrc       : Vertex shader source program string
+//   fsrc       : Fragment shader source program string
+//   retrievable: Whether the binary of the program object will be retrieved
+inline GLuint createProgram(const char *vsrc, const char *fsrc, bool retrievable = false) {
+    TRACE_FUNCTION();
+    return finishProgram(submitProgram(vsrc, fsrc, retrievable));
+}
+
+// Returns the memory from which the shader source file was loaded
+//   name  : Shader source file name
+//   buffer: Text of the loaded source file
+inline bool readShaderSource(const char *name, std::vector<GLchar> &buffer) {
+    TRACE_FUNCTION();
+
+    if (name == nullptr) {
+        return false;
+    }
+
+    std::ifstream file(name, std::ios::binary);
+    if (file.fail()) {
+        std::cerr << "Error: Can't open source file: " << name << std::endl;
+        return false;
+    }
+
+    // Move to the end of the file and get the current position(= file size)
+    file.seekg(0L, std::ios::end);
+    GLsizei length = static_cast<GLsizei>(file.tellg());
+
+    // Allocate file size memory
+    buffer.resize(length + 1);
+
+    // Read the file from the beginning
+    file.seekg(0L, std::ios::beg);
+    file.read(buffer.data(), length);
+    buffer[length] = '\0';
+
+    if (file.fail()) {
+        std::cerr << "Error: Could not read source file: " << name << std::endl;
+        file.close();
+        return false;
+    }
+
+    // Read success
+    file.close();
+    return true;
+}
+
+// Read shader source file and create program object
+//   vert: Vertex shader source file name
+//   frag: Source file name of the fragment shader
+inline GLuint loadProgram(const char *vert, const char *frag) {
+    // Load shader source file
+    std::vector<GLchar> vsrc;
+    const bool vstat(readShaderSource(vert, vsrc));
+    std::vector<GLchar> fsrc;
+    const bool fstat(readShaderSource(frag, fsrc));
+
+    // Create program object
+    return vstat && fstat ? createProgram(vsrc.data(), fsrc.data()) : 0;
+}
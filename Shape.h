@@ -1,4 +1,5 @@
 #pragma once
+#include "InstanceBuffer.h"
 #include "Object.h"
 #include <memory>
 
@@ -17,9 +18,24 @@ class Shape {
     //   vertex     : Array containing the vertex attributes
     //   indexcount : Number of elements at the vertex index
     //   index      : Array containing the indices of the vertices
+    //   layout     : Layout of the vertex attributes in the buffer object
     Shape(GLint size, GLsizei vertexcount, const Object::Vertex *vertex, GLsizei indexcount = 0,
-          const GLuint *index = nullptr)
-        : object(new Object(size, vertexcount, vertex, indexcount, index)), vertexcount(vertexcount) {}
+          const GLuint *index = nullptr, const VertexLayout &layout = VertexLayout())
+        : object(new Object(size, vertexcount, vertex, indexcount, index, layout)), vertexcount(vertexcount) {}
+
+    // Constructor filling the buffer objects in place
+    //   size       : Dimension of the vertex position
+    //   vertexcount: Number of vertices
+    //   indexcount : Number of elements at the vertex index
+    //   fill       : Function writing the vertex attributes and the indices
+    //   layout     : Layout of the vertex attributes in the buffer object
+    Shape(GLint size, GLsizei vertexcount, GLsizei indexcount, const Object::Fill &fill,
+          const VertexLayout &layout = VertexLayout())
+        : object(new Object(size, vertexcount, indexcount, fill, layout)), vertexcount(vertexcount) {}
+
+    // Constructor of a shape without vertex attributes
+    //   vertexcount: Number of vertices generated by the vertex shader
+    explicit Shape(GLsizei vertexcount) : object(new Object()), vertexcount(vertexcount) {}
 
     void draw() const {
         // Merge vertex array object
@@ -28,5 +44,22 @@ class Shape {
         execute();
     }
 
+    // Draw all instances in a buffer with a single draw call
+    //   instances: Per-instance attributes
+    void drawInstanced(const InstanceBuffer &instances) const {
+        // Merge vertex array object
+        object->bind();
+        // Refer to the per-instance attributes
+        instances.attach();
+        // Execute drawing
+        executeInstanced(instances.size());
+    }
+
     virtual void execute() const { glDrawArrays(GL_LINE_LOOP, 0, vertexcount); }
+
+    // Execute instanced drawing
+    //   count: Number of instances
+    virtual void executeInstanced(GLsizei count) const {
+        glDrawArraysInstanced(GL_LINE_LOOP, 0, vertexcount, count);
+    }
 };
\ No newline at end of file
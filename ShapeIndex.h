@@ -9,6 +9,9 @@ class ShapeIndex : public Shape {
     // The number of vertices used in the shape
     const GLsizei indexcount;
 
+    // Type of the indices, 16 bits when the vertices are few enough
+    const GLenum indextype;
+
   public:
     // Constructor
     //   size       : Dimension of the vertex position
@@ -16,12 +19,31 @@ class ShapeIndex : public Shape {
     //   vertex     : Array containing the vertex attributes
     //   indexcount : Number of elements at the vertex index
     //   index      : Array containing the indices of the vertices
-    ShapeIndex(GLint size, GLsizei vertexcount, const Object::Vertex *vertex, GLsizei indexcount, const GLuint *index)
-        : Shape(size, vertexcount, vertex, indexcount, index), indexcount(indexcount) {}
+    //   layout     : Layout of the vertex attributes in the buffer object
+    ShapeIndex(GLint size, GLsizei vertexcount, const Object::Vertex *vertex, GLsizei indexcount, const GLuint *index,
+               const VertexLayout &layout = VertexLayout())
+        : Shape(size, vertexcount, vertex, indexcount, index, layout), indexcount(indexcount),
+          indextype(Object::getIndexType(vertexcount)) {}
+
+    // Constructor filling the buffer objects in place
+    //   size       : Dimension of the vertex position
+    //   vertexcount: Number of vertices
+    //   indexcount : Number of elements at the vertex index
+    //   fill       : Function writing the vertex attributes and the indices
+    //   layout     : Layout of the vertex attributes in the buffer object
+    ShapeIndex(GLint size, GLsizei vertexcount, GLsizei indexcount, const Object::Fill &fill,
+               const VertexLayout &layout = VertexLayout())
+        : Shape(size, vertexcount, indexcount, fill, layout), indexcount(indexcount),
+          indextype(Object::getIndexType(vertexcount)) {}
 
     // Execute drawing
     void execute() const override {
         // Drawing by line segment group
-        glDrawElements(GL_LINES, indexcount, GL_UNSIGNED_INT, nullptr);
+        glDrawElements(GL_LINES, indexcount, indextype, nullptr);
+    }
+
+    // Execute instanced drawing
+    void executeInstanced(GLsizei count) const override {
+        glDrawElementsInstanced(GL_LINES, indexcount, indextype, nullptr, count);
     }
 };
\ No newline at end of file
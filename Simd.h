@@ -0,0 +1,128 @@
+#pragma once
+#include <GL/glew.h>
+
+// Select the instruction set at compile time
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SIMD_SSE 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Small wrapper of four packed single-precision values
+//   Every function has a scalar fallback, so the results only differ by rounding
+namespace simd {
+
+#if defined(SIMD_SSE)
+using float4 = __m128;
+#elif defined(SIMD_NEON)
+using float4 = float32x4_t;
+#else
+struct float4 {
+    GLfloat v[4];
+};
+#endif
+
+// Load four values from memory (no alignment required)
+inline float4 load(const GLfloat *p) {
+#if defined(SIMD_SSE)
+    return _mm_loadu_ps(p);
+#elif defined(SIMD_NEON)
+    return vld1q_f32(p);
+#else
+    return {{p[0], p[1], p[2], p[3]}};
+#endif
+}
+
+// Store four values to memory (no alignment required)
+inline void store(GLfloat *p, float4 a) {
+#if defined(SIMD_SSE)
+    _mm_storeu_ps(p, a);
+#elif defined(SIMD_NEON)
+    vst1q_f32(p, a);
+#else
+    for (int i = 0; i < 4; ++i) {
+        p[i] = a.v[i];
+    }
+#endif
+}
+
+// Set the same value to all four lanes
+inline float4 splat(GLfloat s) {
+#if defined(SIMD_SSE)
+    return _mm_set1_ps(s);
+#elif defined(SIMD_NEON)
+    return vdupq_n_f32(s);
+#else
+    return {{s, s, s, s}};
+#endif
+}
+
+// Addition
+inline float4 add(float4 a, float4 b) {
+#if defined(SIMD_SSE)
+    return _mm_add_ps(a, b);
+#elif defined(SIMD_NEON)
+    return vaddq_f32(a, b);
+#else
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+#endif
+}
+
+// Multiplication
+inline float4 mul(float4 a, float4 b) {
+#if defined(SIMD_SSE)
+    return _mm_mul_ps(a, b);
+#elif defined(SIMD_NEON)
+    return vmulq_f32(a, b);
+#else
+    return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+#endif
+}
+
+// Multiply-add a * b + c (fused when the target supports it)
+inline float4 madd(float4 a, float4 b, float4 c) {
+#if defined(SIMD_SSE) && defined(__FMA__)
+    return _mm_fmadd_ps(a, b, c);
+#elif defined(SIMD_SSE)
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+    return vfmaq_f32(c, a, b);
+#elif defined(SIMD_NEON)
+    return vmlaq_f32(c, a, b);
+#else
+    return add(mul(a, b), c);
+#endif
+}
+
+// Minimum of each lane
+inline float4 min(float4 a, float4 b) {
+#if defined(SIMD_SSE)
+    return _mm_min_ps(a, b);
+#elif defined(SIMD_NEON)
+    return vminq_f32(a, b);
+#else
+    return {{a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], a.v[2] < b.v[2] ? a.v[2] : b.v[2],
+             a.v[3] < b.v[3] ? a.v[3] : b.v[3]}};
+#endif
+}
+
+// Bit mask of the lanes less than zero, bit i for lane i
+inline int negative(float4 a) {
+#if defined(SIMD_SSE)
+    return _mm_movemask_ps(_mm_cmplt_ps(a, _mm_setzero_ps()));
+#elif defined(SIMD_NEON)
+    static const uint32_t bit[4] = {1, 2, 4, 8};
+    const uint32x4_t m(vandq_u32(vcltq_f32(a, vdupq_n_f32(0.0f)), vld1q_u32(bit)));
+#if defined(__aarch64__)
+    return static_cast<int>(vaddvq_u32(m));
+#else
+    return static_cast<int>(vgetq_lane_u32(m, 0) | vgetq_lane_u32(m, 1) | vgetq_lane_u32(m, 2) | vgetq_lane_u32(m, 3));
+#endif
+#else
+    return (a.v[0] < 0.0f) | (a.v[1] < 0.0f) << 1 | (a.v[2] < 0.0f) << 2 | (a.v[3] < 0.0f) << 3;
+#endif
+}
+
+} // namespace simd
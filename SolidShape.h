@@ -18,4 +18,9 @@ class SolidShape : public Shape {
         // Drawing by line segment group
         glDrawArrays(GL_TRIANGLES, 0, vertexcount);
     }
+
+    // Execute instanced drawing
+    void executeInstanced(GLsizei count) const override {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, vertexcount, count);
+    }
 };
\ No newline at end of file
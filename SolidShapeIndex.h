@@ -12,13 +12,29 @@ class SolidShapeIndex : public ShapeIndex {
     //   vertex     : Array containing the vertex attributes
     //   indexcount : Number of elements at the vertex index
     //   index      : Array containing the indices of the vertices
+    //   layout     : Layout of the vertex attributes in the buffer object
     SolidShapeIndex(GLint size, GLsizei vertexcount, const Object::Vertex *vertex, GLsizei indexcount,
-                    const GLuint *index)
-        : ShapeIndex(size, vertexcount, vertex, indexcount, index) {}
+                    const GLuint *index, const VertexLayout &layout = VertexLayout())
+        : ShapeIndex(size, vertexcount, vertex, indexcount, index, layout) {}
+
+    // Constructor filling the buffer objects in place
+    //   size       : Dimension of the vertex position
+    //   vertexcount: Number of vertices
+    //   indexcount : Number of elements at the vertex index
+    //   fill       : Function writing the vertex attributes and the indices
+    //   layout     : Layout of the vertex attributes in the buffer object
+    SolidShapeIndex(GLint size, GLsizei vertexcount, GLsizei indexcount, const Object::Fill &fill,
+                    const VertexLayout &layout = VertexLayout())
+        : ShapeIndex(size, vertexcount, indexcount, fill, layout) {}
 
     // Execute drawing
     void execute() const override {
         // Drawing by line segment group
-        glDrawElements(GL_TRIANGLES, indexcount, GL_UNSIGNED_INT, nullptr);
+        glDrawElements(GL_TRIANGLES, indexcount, indextype, nullptr);
+    }
+
+    // Execute instanced drawing
+    void executeInstanced(GLsizei count) const override {
+        glDrawElementsInstanced(GL_TRIANGLES, indexcount, indextype, nullptr, count);
     }
 };
\ No newline at end of file
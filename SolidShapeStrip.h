@@ -0,0 +1,45 @@
+#pragma once
+
+// Drawing shapes with index
+#include "ShapeIndex.h"
+
+// Triangle strip drawing with index
+//   The strips are separated by the largest value of the index type, which restarts the primitive. Primitive restart
+//   is disabled again after the strips are drawn, so the draws that follow see the state they expect
+class SolidShapeStrip : public ShapeIndex {
+    // Enable restarting the strip at the largest index
+    void begin() const {
+        GlState::enable(GL_PRIMITIVE_RESTART);
+        GlState::primitiveRestartIndex(indextype == GL_UNSIGNED_SHORT ? 0xffff : 0xffffffff);
+    }
+
+    // Disable restarting the strip
+    static void end() { GlState::disable(GL_PRIMITIVE_RESTART); }
+
+  public:
+    // Constructor
+    //   size       : Dimension of the vertex position
+    //   vertexcount: Number of vertices
+    //   vertex     : Array containing the vertex attributes
+    //   indexcount : Number of elements at the vertex index
+    //   index      : Array containing the indices of the strips separated by 0xffffffff
+    //   layout     : Layout of the vertex attributes in the buffer object
+    SolidShapeStrip(GLint size, GLsizei vertexcount, const Object::Vertex *vertex, GLsizei indexcount,
+                    const GLuint *index, const VertexLayout &layout = VertexLayout())
+        : ShapeIndex(size, vertexcount, vertex, indexcount, index, layout) {}
+
+    // Execute drawing
+    void execute() const override {
+        // Drawing by triangle strips
+        begin();
+        glDrawElements(GL_TRIANGLE_STRIP, indexcount, indextype, nullptr);
+        end();
+    }
+
+    // Execute instanced drawing
+    void executeInstanced(GLsizei count) const override {
+        begin();
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP, indexcount, indextype, nullptr, count);
+        end();
+    }
+};
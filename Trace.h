@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Scoped CPU trace macros
+//   TRACE_SCOPE(name): Record the time until the end of the enclosing scope, name must be a string literal
+//   TRACE_FUNCTION() : Record the time of the enclosing function
+//   Both compile out completely when NDEBUG is defined (release builds)
+#if !defined(NDEBUG)
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) const Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_FUNCTION() TRACE_SCOPE(__func__)
+#else
+#define TRACE_SCOPE(name) static_cast<void>(0)
+#define TRACE_FUNCTION() static_cast<void>(0)
+#endif
+
+// Recording of CPU trace events, exported in the Chrome trace_event JSON format
+//   Every thread appends to its own buffer without locking, the lock is only taken when a thread records for the first
+//   time and when the events are written out
+class Trace {
+    // Event of a scope
+    struct Event {
+        // Name of the scope, must have the static storage duration
+        const char *name;
+        // Begin and end time in nanoseconds from the start of tracing
+        std::int64_t begin, end;
+    };
+
+    // Block of events, chained when full
+    struct Block {
+        // Number of events in a block
+        static constexpr std::uint32_t capacity = 4096;
+        // Events
+        Event events[capacity];
+        // Number of events published to the reader
+        std::atomic<std::uint32_t> count{0};
+        // Next block
+        std::atomic<Block *> next{nullptr};
+
+        // Destructor
+        ~Block() { delete next.load(); }
+    };
+
+    // Buffer of events of a thread
+    struct Buffer {
+        // Identifier of the thread
+        int tid;
+        // First block, read by the writer of the JSON
+        Block head;
+        // Last block, written only by the owner thread
+        Block *tail{&head};
+
+        // Constructor
+        //   tid: Identifier of the thread
+        explicit Buffer(int tid) : tid(tid) {}
+    };
+
+    // Buffers of all threads, they live until the end of the program
+    static std::vector<std::unique_ptr<Buffer>> &buffers() {
+        static std::vector<std::unique_ptr<Buffer>> b;
+        return b;
+    }
+
+    // Lock of the buffers
+    static std::mutex &mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    // Buffer of the current thread
+    static Buffer &local() {
+        thread_local Buffer *buffer(nullptr);
+        if (buffer == nullptr) {
+            const std::lock_guard<std::mutex> lock(mutex());
+            buffers().emplace_back(new Buffer(static_cast<int>(buffers().size())));
+            buffer = buffers().back().get();
+        }
+        return *buffer;
+    }
+
+  public:
+    // Current time in nanoseconds from the start of tracing
+    static std::int64_t now() {
+        static const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Record an event of the current thread
+    //   name : Name of the event, must have the static storage duration
+    //   begin: Begin time from now()
+    //   end  : End time from now()
+    static void record(const char *name, std::int64_t begin, std::int64_t end) {
+        Buffer &b(local());
+
+        // Chain a new block when the last one is full
+        std::uint32_t n(b.tail->count.load(std::memory_order_relaxed));
+        if (n == Block::capacity) {
+            Block *const block(new Block);
+            b.tail->next.store(block, std::memory_order_release);
+            b.tail = block;
+            n = 0;
+        }
+
+        // Publish the event after writing it
+        b.tail->events[n] = {name, begin, end};
+        b.tail->count.store(n + 1, std::memory_order_release);
+    }
+
+    // Write the recorded events in the Chrome trace_event JSON format
+    //   os: Output stream
+    static void write(std::ostream &os) {
+        const std::lock_guard<std::mutex> lock(mutex());
+        const std::ios_base::fmtflags flags(os.flags());
+        const std::streamsize precision(os.precision(3));
+        os << std::fixed << "{\"traceEvents\":[";
+        const char *separator("\n");
+        for (const std::unique_ptr<Buffer> &b : buffers()) {
+            for (const Block *block = &b->head; block != nullptr; block = block->next.load(std::memory_order_acquire)) {
+                const std::uint32_t n(block->count.load(std::memory_order_acquire));
+                for (std::uint32_t i = 0; i < n; ++i) {
+                    const Event &e(block->events[i]);
+                    os << separator << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                       << ",\"ts\":" << static_cast<double>(e.begin) * 1.0e-3
+                       << ",\"dur\":" << static_cast<double>(e.end - e.begin) * 1.0e-3 << '}';
+                    separator = ",\n";
+                }
+            }
+        }
+        os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    // Save the recorded events to a file
+    //   name: File name
+    static bool save(const char *name) {
+        std::ofstream file(name);
+        write(file);
+        return !file.fail();
+    }
+
+    // Recording of the enclosing scope
+    class Scope {
+        // Name of the scope
+        const char *const name;
+        // Begin time
+        const std::int64_t begin;
+
+      public:
+        // Constructor
+        //   name: Name of the scope, must have the static storage duration
+        explicit Scope(const char *name) : name(name), begin(now()) {}
+
+        // Destructor
+        ~Scope() { record(name, begin, now()); }
+
+        // Copy prohibition
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+};
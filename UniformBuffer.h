@@ -0,0 +1,68 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstring>
+
+// Cache of the OpenGL state
+#include "GlState.h"
+
+// Uniform buffer object shared by program objects through a binding point
+//   T: Structure in the std140 layout of the uniform block
+template <typename T>
+class UniformBuffer {
+    // Uniform buffer object name
+    GLuint ubo{};
+
+    // Binding point of the uniform buffer object
+    const GLuint binding;
+
+    // Copy of the contents of the buffer object
+    T data{};
+
+    // Whether the buffer object has been written
+    bool written{};
+
+  public:
+    // Constructor
+    //   binding: Binding point of the uniform buffer object
+    explicit UniformBuffer(GLuint binding) : binding(binding) {
+        glGenBuffers(1, &ubo);
+        GlState::bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+        GlState::bindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+    }
+
+    // Destructor
+    virtual ~UniformBuffer() { GlState::deleteBuffers(1, &ubo); }
+
+    // Copy prohibition
+    UniformBuffer(const UniformBuffer &) = delete;
+    UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+    // Connect a uniform block of a program object to the binding point
+    //   Only needs to be done once per program object
+    //   program: Program object name
+    //   name   : Name of the uniform block
+    void bind(GLuint program, const char *name) const {
+        const GLuint index(glGetUniformBlockIndex(program, name));
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, index, binding);
+        }
+    }
+
+    // Write the contents to the buffer object only when they have changed
+    //   t: Contents of the uniform block
+    //   Returns true if the buffer object was written
+    bool set(const T &t) {
+        if (written && std::memcmp(&data, &t, sizeof(T)) == 0) {
+            return false;
+        }
+        data = t;
+        written = true;
+        GlState::bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+        return true;
+    }
+
+    // Retrieve the contents
+    [[nodiscard]] const T &get() const { return data; }
+};
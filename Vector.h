@@ -10,10 +10,15 @@ using Vector = std::array<GLfloat, 4>;
 // Matrix and Vector Multiplication
 //   m: Matrix of type matrix
 //   n: Vector of type vector
-Vector operator*(const Matrix &m, const Vector &v) {
-    Vector t;
-    for (int i = 0; i < 4; ++i) {
-        t[i] = m[i] * v[0] + m[i + 4] * v[1] + m[i + 8] * v[2] + m[i + 12] * v[3];
-    }
-    return t;
+template <typename Kind>
+inline Vector operator*(const BasicMatrix<Kind> &m, const Vector &v) {
+    // Linear combination of the columns of m weighted by the elements of v
+    simd::float4 t(simd::mul(simd::load(m.data() + 0), simd::splat(v[0])));
+    t = simd::madd(simd::load(m.data() + 4), simd::splat(v[1]), t);
+    t = simd::madd(simd::load(m.data() + 8), simd::splat(v[2]), t);
+    t = simd::madd(simd::load(m.data() + 12), simd::splat(v[3]), t);
+
+    Vector u;
+    simd::store(u.data(), t);
+    return u;
 }
\ No newline at end of file
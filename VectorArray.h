@@ -0,0 +1,144 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Vector
+#include "Vector.h"
+
+// View of vectors stored in structure-of-arrays form
+//   Every span has the same number of elements
+template <typename T>
+struct BasicVectorSpan {
+    std::span<T> x, y, z, w;
+
+    // Number of vectors
+    [[nodiscard]] std::size_t size() const { return x.size(); }
+
+    // Conversion to the read-only view
+    operator BasicVectorSpan<const T>() const
+        requires(!std::is_const_v<T>)
+    {
+        return {x, y, z, w};
+    }
+};
+using VectorSpan = BasicVectorSpan<GLfloat>;
+using ConstVectorSpan = BasicVectorSpan<const GLfloat>;
+
+// Array of vectors stored in structure-of-arrays form
+class VectorArray {
+    // Each component of the vectors
+    std::vector<GLfloat> x, y, z, w;
+
+  public:
+    // Constructor
+    //   count: Number of vectors
+    explicit VectorArray(std::size_t count = 0) : x(count), y(count), z(count), w(count, 1.0f) {}
+
+    // Constructor initialized with the contents of an array of vectors
+    //   first, last: Range of the vectors
+    VectorArray(const Vector *first, const Vector *last) : VectorArray(static_cast<std::size_t>(last - first)) {
+        for (std::size_t i = 0; i < size(); ++i) {
+            set(i, first[i]);
+        }
+    }
+
+    // Number of vectors
+    [[nodiscard]] std::size_t size() const { return x.size(); }
+
+    // Change the number of vectors, new vectors are (0, 0, 0, 1)
+    void resize(std::size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        w.resize(count, 1.0f);
+    }
+
+    // Gather the i-th vector
+    [[nodiscard]] Vector operator[](std::size_t i) const { return {x[i], y[i], z[i], w[i]}; }
+
+    // Scatter a vector to the i-th element
+    void set(std::size_t i, const Vector &v) {
+        x[i] = v[0];
+        y[i] = v[1];
+        z[i] = v[2];
+        w[i] = v[3];
+    }
+
+    // Returns the view of the components
+    [[nodiscard]] VectorSpan span() { return {x, y, z, w}; }
+    [[nodiscard]] ConstVectorSpan span() const { return {x, y, z, w}; }
+};
+
+// Transform positions by a matrix
+//   m  : Transformation matrix
+//   in : Vectors to be transformed
+//   out: Storage location of the transformed vectors, may be the same as in
+template <typename Kind>
+void transform(const BasicMatrix<Kind> &m, ConstVectorSpan in, VectorSpan out) {
+    // The bottom row of an affine transformation keeps w as it is
+    constexpr bool affine(Kind::level >= Affine::level);
+
+    // Elements of the matrix in every lane
+    simd::float4 c[16];
+    for (int i = 0; i < 16; ++i) {
+        c[i] = simd::splat(m[i]);
+    }
+
+    // Transform four vectors at a time
+    const std::size_t n(in.size()), n4(n & ~std::size_t(3));
+    for (std::size_t i = 0; i < n4; i += 4) {
+        const simd::float4 x(simd::load(&in.x[i])), y(simd::load(&in.y[i]));
+        const simd::float4 z(simd::load(&in.z[i])), w(simd::load(&in.w[i]));
+        const auto row([&](int j) {
+            return simd::madd(c[j + 12], w, simd::madd(c[j + 8], z, simd::madd(c[j + 4], y, simd::mul(c[j], x))));
+        });
+        simd::store(&out.x[i], row(0));
+        simd::store(&out.y[i], row(1));
+        simd::store(&out.z[i], row(2));
+        simd::store(&out.w[i], affine ? w : row(3));
+    }
+
+    // Remaining vectors
+    for (std::size_t i = n4; i < n; ++i) {
+        const Vector v(m * Vector{in.x[i], in.y[i], in.z[i], in.w[i]});
+        out.x[i] = v[0];
+        out.y[i] = v[1];
+        out.z[i] = v[2];
+        out.w[i] = v[3];
+    }
+}
+
+// Transform normal vectors by the transformation matrix of the normal vector
+//   w components are not referred to nor changed
+//   m  : 3x3 transformation matrix of the normal vector (see Matrix::getNormalMatrix)
+//   in : Vectors to be transformed
+//   out: Storage location of the transformed vectors, may be the same as in
+inline void transformNormals(const GLfloat *m, ConstVectorSpan in, VectorSpan out) {
+    // Elements of the matrix in every lane
+    simd::float4 c[9];
+    for (int i = 0; i < 9; ++i) {
+        c[i] = simd::splat(m[i]);
+    }
+
+    // Transform four vectors at a time
+    const std::size_t n(in.size()), n4(n & ~std::size_t(3));
+    for (std::size_t i = 0; i < n4; i += 4) {
+        const simd::float4 x(simd::load(&in.x[i])), y(simd::load(&in.y[i])), z(simd::load(&in.z[i]));
+        const simd::float4 tx(simd::madd(c[6], z, simd::madd(c[3], y, simd::mul(c[0], x))));
+        const simd::float4 ty(simd::madd(c[7], z, simd::madd(c[4], y, simd::mul(c[1], x))));
+        const simd::float4 tz(simd::madd(c[8], z, simd::madd(c[5], y, simd::mul(c[2], x))));
+        simd::store(&out.x[i], tx);
+        simd::store(&out.y[i], ty);
+        simd::store(&out.z[i], tz);
+    }
+
+    // Remaining vectors
+    for (std::size_t i = n4; i < n; ++i) {
+        const GLfloat x(in.x[i]), y(in.y[i]), z(in.z[i]);
+        out.x[i] = m[0] * x + m[3] * y + m[6] * z;
+        out.y[i] = m[1] * x + m[4] * y + m[7] * z;
+        out.z[i] = m[2] * x + m[5] * y + m[8] * z;
+    }
+}
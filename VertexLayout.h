@@ -0,0 +1,328 @@
+#pragma once
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Layout of the vertex attributes in a buffer object
+//   Positions are stored as floats, or quantized to half floats or normalized 16-bit integers in the box around the
+//   mesh, whose center and half size the vertex shader uses to restore them. Normals are stored as floats, as two
+//   normalized 16-bit integers of their octahedral mapping, or as three normalized 10-bit integers. The attributes are
+//   quantized on the CPU when they are uploaded
+class VertexLayout {
+  public:
+    // Format of the positions
+    enum class Position { Float, Half, Snorm16 };
+
+    // Format of the normals
+    enum class Normal { Float, Octahedral, Packed };
+
+    // Values restoring the attributes in the vertex shader
+    struct Decode {
+        // Half size of the box around the positions, and 1 in the fourth element if the normals are octahedral
+        GLfloat scale[4];
+
+        // Center of the box around the positions
+        GLfloat offset[4];
+    };
+
+    // Largest differences between the attributes and the ones restored from this layout
+    struct Error {
+        // Difference of a coordinate of the positions relative to the half size of the box around them
+        GLfloat position;
+
+        // Angle between the normals in radians
+        GLfloat normal;
+    };
+
+    // Location of the scale and the offset in the vertex shader, which take two locations
+    static constexpr GLuint decodeLocation = 10;
+
+  private:
+    // Format of the positions
+    Position position;
+
+    // Format of the normals
+    Normal normal;
+
+  public:
+    // Constructor
+    //   position: Format of the positions
+    //   normal  : Format of the normals
+    constexpr explicit VertexLayout(Position position = Position::Float, Normal normal = Normal::Float)
+        : position(position), normal(normal) {}
+
+    // Whether both attributes are stored as floats in the layout of Object::Vertex
+    [[nodiscard]] constexpr bool isFloat() const { return position == Position::Float && normal == Normal::Float; }
+
+    // Number of bytes of the position of a vertex
+    [[nodiscard]] constexpr GLsizei getPositionSize() const { return position == Position::Float ? 12 : 8; }
+
+    // Number of bytes of a vertex
+    [[nodiscard]] constexpr GLsizei getStride() const {
+        return getPositionSize() + (normal == Normal::Float ? 12 : 4);
+    }
+
+    // Byte offset of the position in a vertex
+    [[nodiscard]] constexpr GLsizei getPositionOffset() const { return 0; }
+
+    // Byte offset of the normal in a vertex
+    [[nodiscard]] constexpr GLsizei getNormalOffset() const { return getPositionSize(); }
+
+    // Point the vertex attributes of the bound vertex array object at the bound buffer object
+    //   size: Dimension of the vertex position
+    void setup(GLint size) const {
+        static constexpr GLenum positionType[] = {GL_FLOAT, GL_HALF_FLOAT, GL_SHORT};
+        glVertexAttribPointer(0, size, positionType[static_cast<int>(position)],
+                              position == Position::Snorm16 ? GL_TRUE : GL_FALSE, getStride(),
+                              reinterpret_cast<const GLvoid *>(static_cast<std::uintptr_t>(getPositionOffset())));
+        glEnableVertexAttribArray(0);
+        const GLvoid *const offset(reinterpret_cast<const GLvoid *>(static_cast<std::uintptr_t>(getNormalOffset())));
+        if (normal == Normal::Float) {
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, getStride(), offset);
+        } else if (normal == Normal::Octahedral) {
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, getStride(), offset);
+        } else {
+            glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, getStride(), offset);
+        }
+        glEnableVertexAttribArray(1);
+    }
+
+    // Values restoring the attributes of a mesh
+    //   vertex: Vertex attributes
+    //   count : Number of vertices
+    template <typename V>
+    [[nodiscard]] Decode getDecode(const V *vertex, std::size_t count) const {
+        Decode d{{1.0f, 1.0f, 1.0f, normal == Normal::Octahedral ? 1.0f : 0.0f}, {}};
+        if (position == Position::Float || count == 0) {
+            return d;
+        }
+        for (int i = 0; i < 3; ++i) {
+            GLfloat lower(vertex[0].position[i]), upper(lower);
+            for (std::size_t k = 1; k < count; ++k) {
+                lower = std::min(lower, vertex[k].position[i]);
+                upper = std::max(upper, vertex[k].position[i]);
+            }
+            d.offset[i] = (lower + upper) * 0.5f;
+            d.scale[i] = upper > lower ? (upper - lower) * 0.5f : 1.0f;
+        }
+        return d;
+    }
+
+    // Write vertex attributes in this layout
+    //   vertex: Vertex attributes
+    //   count : Number of vertices
+    //   d     : Values restoring the attributes
+    //   out   : Storage location of count * getStride() bytes
+    template <typename V>
+    void quantize(const V *vertex, std::size_t count, const Decode &d, void *out) const {
+        unsigned char *p(static_cast<unsigned char *>(out));
+        for (std::size_t k = 0; k < count; ++k, p += getStride()) {
+            // Position relative to the box
+            GLfloat v[3];
+            for (int i = 0; i < 3; ++i) {
+                v[i] = (vertex[k].position[i] - d.offset[i]) / d.scale[i];
+            }
+            if (position == Position::Float) {
+                std::memcpy(p + getPositionOffset(), v, sizeof v);
+            } else {
+                std::uint16_t c[4]{};
+                for (int i = 0; i < 3; ++i) {
+                    c[i] = position == Position::Half ? toHalf(v[i])
+                                                      : static_cast<std::uint16_t>(toSnorm(v[i], 32767));
+                }
+                std::memcpy(p + getPositionOffset(), c, sizeof c);
+            }
+
+            // Normal
+            unsigned char *const q(p + getNormalOffset());
+            const GLfloat *const n(vertex[k].normal);
+            if (normal == Normal::Float) {
+                std::memcpy(q, n, 3 * sizeof(GLfloat));
+            } else if (normal == Normal::Octahedral) {
+                GLfloat e[2];
+                toOctahedral(n, e);
+                const std::int16_t c[2]{static_cast<std::int16_t>(toSnorm(e[0], 32767)),
+                                        static_cast<std::int16_t>(toSnorm(e[1], 32767))};
+                std::memcpy(q, c, sizeof c);
+            } else {
+                // Normalized and packed into the lower 30 bits of GL_INT_2_10_10_10_REV
+                const GLfloat l(std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+                std::uint32_t c(0);
+                for (int i = 0; i < 3; ++i) {
+                    c |= (static_cast<std::uint32_t>(toSnorm(l > 0.0f ? n[i] / l : 0.0f, 511)) & 0x3ffu) << (10 * i);
+                }
+                std::memcpy(q, &c, sizeof c);
+            }
+        }
+    }
+
+    // Read back a vertex the way the vertex shader does
+    //   in: Vertex attributes in this layout
+    //   k : Vertex
+    //   d : Values restoring the attributes
+    //   v : Storage location of the vertex attributes, with a normalized normal
+    template <typename V>
+    void restore(const void *in, std::size_t k, const Decode &d, V &v) const {
+        const unsigned char *const p(static_cast<const unsigned char *>(in) + k * getStride() + getPositionOffset());
+        GLfloat r[3];
+        if (position == Position::Float) {
+            std::memcpy(r, p, sizeof r);
+        } else {
+            std::int16_t c[3];
+            std::memcpy(c, p, sizeof c);
+            for (int i = 0; i < 3; ++i) {
+                r[i] = position == Position::Half ? fromHalf(static_cast<std::uint16_t>(c[i]))
+                                                  : std::max(static_cast<GLfloat>(c[i]) / 32767.0f, -1.0f);
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            v.position[i] = r[i] * d.scale[i] + d.offset[i];
+        }
+
+        const unsigned char *const q(static_cast<const unsigned char *>(in) + k * getStride() + getNormalOffset());
+        GLfloat *const n(v.normal);
+        if (normal == Normal::Float) {
+            std::memcpy(n, q, 3 * sizeof(GLfloat));
+        } else if (normal == Normal::Octahedral) {
+            std::int16_t c[2];
+            std::memcpy(c, q, sizeof c);
+            const GLfloat e[2]{std::max(c[0] / 32767.0f, -1.0f), std::max(c[1] / 32767.0f, -1.0f)};
+            fromOctahedral(e, n);
+        } else {
+            std::uint32_t c;
+            std::memcpy(&c, q, sizeof c);
+            for (int i = 0; i < 3; ++i) {
+                // Sign extension of the 10 bits
+                const std::int32_t s(static_cast<std::int32_t>((c >> (10 * i)) & 0x3ffu) << 22 >> 22);
+                n[i] = std::max(static_cast<GLfloat>(s) / 511.0f, -1.0f);
+            }
+        }
+        const GLfloat l(std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+        if (l > 0.0f) {
+            for (int i = 0; i < 3; ++i) {
+                n[i] /= l;
+            }
+        }
+    }
+
+    // Largest differences between the attributes of a mesh and the ones restored from this layout
+    //   vertex: Vertex attributes
+    //   count : Number of vertices
+    template <typename V>
+    [[nodiscard]] Error getError(const V *vertex, std::size_t count) const {
+        const Decode d(getDecode(vertex, count));
+        Error error{};
+        unsigned char data[24];
+        for (std::size_t k = 0; k < count; ++k) {
+            quantize(vertex + k, 1, d, data);
+            V v;
+            restore(data, 0, d, v);
+            for (int i = 0; i < 3; ++i) {
+                error.position = std::max(error.position, std::abs(v.position[i] - vertex[k].position[i]) / d.scale[i]);
+            }
+
+            // Angle from the cross and dot products, which stays accurate for small angles
+            double a[3], b[3];
+            std::copy(vertex[k].normal, vertex[k].normal + 3, a);
+            std::copy(v.normal, v.normal + 3, b);
+            const double c[3]{a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+            const double s(std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]));
+            const double t(a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+            if (s > 0.0 || t > 0.0) {
+                error.normal = std::max(error.normal, static_cast<GLfloat>(std::atan2(s, t)));
+            }
+        }
+        return error;
+    }
+
+    // Bounds of the differences between the attributes and the ones restored from this layout
+    //   Either conversion of normalized integers of OpenGL, before and after version 4.2, is within the bounds
+    [[nodiscard]] Error getTolerance() const {
+        static constexpr GLfloat position[] = {1.0e-6f, 1.0f / 2048.0f, 1.0f / 32767.0f};
+        static constexpr GLfloat normal[] = {1.0e-6f, 2.0f * 1.732051f / 32767.0f, 1.732051f / 511.0f};
+        return {position[static_cast<int>(this->position)], normal[static_cast<int>(this->normal)]};
+    }
+
+  private:
+    // Normalized integer of a number between -1 and 1
+    //   x  : Number
+    //   max: Largest integer
+    static std::int32_t toSnorm(GLfloat x, std::int32_t max) {
+        return static_cast<std::int32_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * static_cast<GLfloat>(max)));
+    }
+
+    // Half float nearest to a float, rounding ties to even
+    static std::uint16_t toHalf(GLfloat f) {
+        std::uint32_t x;
+        std::memcpy(&x, &f, sizeof x);
+        const std::uint32_t sign((x >> 16) & 0x8000u);
+        x &= 0x7fffffffu;
+        if (x >= 0x47800000u) {
+            // Too large, infinity or not a number
+            return static_cast<std::uint16_t>(sign | 0x7c00u | (x > 0x7f800000u ? 0x200u : 0u));
+        }
+        if (x < 0x38800000u) {
+            // Denormalized number or zero
+            if (x < 0x33000000u) {
+                return static_cast<std::uint16_t>(sign);
+            }
+            const std::uint32_t shift(126u - (x >> 23)), m((x & 0x7fffffu) | 0x800000u);
+            std::uint32_t h(m >> shift);
+            const std::uint32_t rest(m & ((1u << shift) - 1u)), half(1u << (shift - 1u));
+            if (rest > half || (rest == half && (h & 1u) != 0u)) {
+                ++h;
+            }
+            return static_cast<std::uint16_t>(sign | h);
+        }
+        std::uint32_t h((x - 0x38000000u) >> 13);
+        const std::uint32_t rest(x & 0x1fffu);
+        if (rest > 0x1000u || (rest == 0x1000u && (h & 1u) != 0u)) {
+            ++h;
+        }
+        return static_cast<std::uint16_t>(sign | h);
+    }
+
+    // Float of a half float
+    static GLfloat fromHalf(std::uint16_t h) {
+        const int e((h >> 10) & 0x1f), m(h & 0x3ff);
+        const GLfloat v(e == 0    ? std::ldexp(static_cast<GLfloat>(m), -24)
+                        : e == 31 ? (m != 0 ? NAN : INFINITY)
+                                  : std::ldexp(static_cast<GLfloat>(m | 0x400), e - 25));
+        return (h & 0x8000) != 0 ? -v : v;
+    }
+
+    // Octahedral mapping of a direction, folding the lower half over the diagonals
+    //   n: Direction
+    //   e: Storage location of the two coordinates between -1 and 1
+    static void toOctahedral(const GLfloat *n, GLfloat *e) {
+        const GLfloat l(std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]));
+        if (l == 0.0f) {
+            e[0] = e[1] = 0.0f;
+            return;
+        }
+        const GLfloat x(n[0] / l), y(n[1] / l);
+        if (n[2] >= 0.0f) {
+            e[0] = x;
+            e[1] = y;
+        } else {
+            e[0] = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            e[1] = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        }
+    }
+
+    // Direction of an octahedral mapping, not normalized
+    //   e: Two coordinates between -1 and 1
+    //   n: Storage location of the direction
+    static void fromOctahedral(const GLfloat *e, GLfloat *n) {
+        n[0] = e[0];
+        n[1] = e[1];
+        n[2] = 1.0f - std::abs(e[0]) - std::abs(e[1]);
+        if (n[2] < 0.0f) {
+            n[0] = (1.0f - std::abs(e[1])) * (e[0] >= 0.0f ? 1.0f : -1.0f);
+            n[1] = (1.0f - std::abs(e[0])) * (e[1] >= 0.0f ? 1.0f : -1.0f);
+        }
+    }
+};
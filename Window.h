@@ -1,7 +1,15 @@
 #pragma once
 #include <GL/glew.h>
+#include "Trace.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <string_view>
+#if defined(HAVE_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 // Window-related process
 class Window {
@@ -15,12 +23,46 @@ class Window {
     GLfloat location[2];
     // Key status
     int keyStatus;
+    // Location on the normalized device coordinate system of the last click of the right mouse button
+    GLfloat cursor[2]{};
+    // Whether the right mouse button is held, and whether it has been pressed in this frame
+    bool pressed{}, clicked{};
+#if defined(HAVE_EGL)
+    // EGL display and rendering context of the offscreen rendering
+    EGLDisplay display{EGL_NO_DISPLAY};
+    EGLContext context{EGL_NO_CONTEXT};
+#endif
+    // Frame buffer object of the offscreen rendering and its color and depth render buffers
+    GLuint framebuffer{};
+    GLuint renderbuffer[2]{};
+    // Number of frames to be drawn offscreen
+    int frames{};
+    // Number of frames drawn so far
+    int frame{};
+    // Time when the first frame started
+    std::chrono::steady_clock::time_point start;
+
+    // Init GLEW for the current context
+    static GLenum initGlew() {
+        TRACE_FUNCTION();
+        glewExperimental = GL_TRUE;
+        return glewInit();
+    }
 
   public:
+    // Settings of the offscreen rendering without a display
+    struct Offscreen {
+        // Size of the frame buffer
+        int width, height;
+        // Number of frames drawn before the drawing loop ends
+        int frames;
+    };
+
     // Constructor
     explicit Window(int width = 640, int height = 480, const char *title = "Hello!")
         : window(glfwCreateWindow(width, height, title, nullptr, nullptr)), scale(100.0f), location{0.0f, 0.0f},
           keyStatus(GLFW_RELEASE) {
+        TRACE_SCOPE("Window");
 
         if (window == nullptr) {
             // can not create window
@@ -32,8 +74,7 @@ class Window {
         glfwMakeContextCurrent(window);
 
         // Init GLEW
-        glewExperimental = GL_TRUE;
-        if (glewInit() != GLEW_OK) {
+        if (initGlew() != GLEW_OK) {
             // Fail init
             std::cerr << "Can't initialize GLEW" << std::endl;
             exit(1);
@@ -58,11 +99,147 @@ class Window {
         resize(window, width, height);
     }
 
+    // Constructor for the offscreen rendering
+    //   Renders to a frame buffer object on a surfaceless EGL context, so neither a display nor a GPU is needed
+    explicit Window(const Offscreen &offscreen)
+        : window(nullptr), scale(100.0f), location{0.0f, 0.0f}, keyStatus(GLFW_RELEASE), frames(offscreen.frames) {
+        TRACE_SCOPE("Window");
+#if defined(HAVE_EGL)
+        // Whether the space separated list of extensions of a display, or of the client, contains the name
+        const auto hasExtension([](EGLDisplay d, std::string_view name) {
+            const char *const list(eglQueryString(d, EGL_EXTENSIONS));
+            for (std::string_view rest(list != nullptr ? list : ""); !rest.empty();) {
+                const std::size_t end(std::min(rest.find(' '), rest.size()));
+                if (rest.substr(0, end) == name) {
+                    return true;
+                }
+                rest.remove_prefix(std::min(end + 1, rest.size()));
+            }
+            return false;
+        });
+
+        // Get the display without a window system if possible, or else the default display
+        const auto getPlatformDisplay(
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT")));
+        if (getPlatformDisplay != nullptr && hasExtension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr) == EGL_FALSE) {
+                display = EGL_NO_DISPLAY;
+            }
+        }
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr) == EGL_FALSE) {
+                display = EGL_NO_DISPLAY;
+            }
+        }
+        if (display == EGL_NO_DISPLAY) {
+            std::cerr << "Can't initialize EGL display." << std::endl;
+            exit(1);
+        }
+
+        // Select OpenGL version 3.2 Core Profile
+        static constexpr EGLint configAttribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        static constexpr EGLint contextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                                    3,
+                                                    EGL_CONTEXT_MINOR_VERSION,
+                                                    2,
+                                                    EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                                    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                                    EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE,
+                                                    EGL_TRUE,
+                                                    EGL_NONE};
+        EGLConfig config;
+        EGLint configCount;
+        if (eglChooseConfig(display, configAttribs, &config, 1, &configCount) == EGL_FALSE || configCount < 1) {
+            // Surfaceless displays may have no config at all, which is fine without a surface where it is supported
+            if (!hasExtension(display, "EGL_KHR_no_config_context")) {
+                std::cerr << "Can't find an EGL config for OpenGL." << std::endl;
+                eglTerminate(display);
+                exit(1);
+            }
+            config = EGL_NO_CONFIG_KHR;
+        }
+        if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE ||
+            (context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs)) == EGL_NO_CONTEXT ||
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_FALSE) {
+            std::cerr << "Can't create EGL context." << std::endl;
+            exit(1);
+        }
+#else
+        std::cerr << "Offscreen rendering is not supported on this platform." << std::endl;
+        exit(1);
+#endif
+
+        // Init GLEW, the GLX part fails without a display but the OpenGL functions are already loaded
+        const GLenum error(initGlew());
+#if defined(GLEW_ERROR_NO_GLX_DISPLAY)
+        if (error != GLEW_OK && error != GLEW_ERROR_NO_GLX_DISPLAY) {
+#else
+        if (error != GLEW_OK) {
+#endif
+            std::cerr << "Can't initialize GLEW" << std::endl;
+            exit(1);
+        }
+
+        // Frame buffer object to draw to instead of the window
+        glGenRenderbuffers(2, renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, offscreen.width, offscreen.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, offscreen.width, offscreen.height);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer[0]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer[1]);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Can't create offscreen frame buffer." << std::endl;
+            exit(1);
+        }
+
+        // Initial settings for the frame buffer
+        glViewport(0, 0, offscreen.width, offscreen.height);
+        size[0] = static_cast<GLfloat>(offscreen.width);
+        size[1] = static_cast<GLfloat>(offscreen.height);
+    }
+
     // Destructor
-    virtual ~Window() { glfwDestroyWindow(window); }
+    virtual ~Window() {
+        if (window != nullptr) {
+            glfwDestroyWindow(window);
+            return;
+        }
+
+        // Release the offscreen resources
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(2, renderbuffer);
+#if defined(HAVE_EGL)
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+#endif
+    }
 
     // Continuation check of the drawing loop
     explicit operator bool() {
+        if (window == nullptr) {
+            // Offscreen rendering continues until the given number of frames are drawn
+            if (frame == 0) {
+                start = std::chrono::steady_clock::now();
+            }
+            if (frame < frames) {
+                ++frame;
+                return true;
+            }
+
+            // Wait for the completion of drawing and report the throughput
+            glFinish();
+            const std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+            std::cout << frame << " frames in " << elapsed.count() << " s (" << frame / elapsed.count()
+                      << " frames/s)" << std::endl;
+            return false;
+        }
+
         // Extract events
         glfwPollEvents();
 
@@ -89,12 +266,28 @@ class Window {
             location[1] = 1.0f - static_cast<GLfloat>(y) * 2.0f / size[1];
         }
 
+        // Check right mouse button, which only counts when it goes down
+        const bool down(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_2) != GLFW_RELEASE);
+        clicked = down && !pressed;
+        pressed = down;
+        if (clicked) {
+            double x, y;
+            glfwGetCursorPos(window, &x, &y);
+            cursor[0] = static_cast<GLfloat>(x) * 2.0f / size[0] - 1.0f;
+            cursor[1] = 1.0f - static_cast<GLfloat>(y) * 2.0f / size[1];
+        }
+
         // Return true if the window does not need to be closed
         return !glfwWindowShouldClose(window) && !glfwGetKey(window, GLFW_KEY_ESCAPE);
     }
 
     // Double buffering
     void swapBuffers() const {
+        // Nothing to replace when drawing offscreen
+        if (window == nullptr) {
+            return;
+        }
+
         // Replace the color buffer
         glfwSwapBuffers(window);
     }
@@ -146,4 +339,14 @@ class Window {
 
     // Retrieve the position
     [[nodiscard]] const GLfloat *getLocation() const { return location; }
+
+    // Whether the right mouse button has been clicked in this frame
+    [[nodiscard]] bool isClicked() const { return clicked; }
+
+    // Retrieve the position of the last click on the normalized device coordinate system
+    [[nodiscard]] const GLfloat *getCursor() const { return cursor; }
+
+    // Retrieve the elapsed time in seconds
+    //   Offscreen rendering advances 1/60 s every frame so that the results are reproducible
+    [[nodiscard]] double getTime() const { return window != nullptr ? glfwGetTime() : frame / 60.0; }
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#version 150 core
+#extension GL_ARB_explicit_attrib_location: enable
+#ifndef KAMB
+#define KAMB vec3(0.6, 0.6, 0.2)
+#endif
+#ifndef KDIFF
+#define KDIFF vec3(0.6, 0.6, 0.2)
+#endif
+#ifndef KSPEC
+#define KSPEC vec3(0.3, 0.3, 0.3)
+#endif
+#ifndef KSHI
+#define KSHI 30.0
+#endif
+layout (std140) uniform Cluster {
+    ivec4 grid;
+    vec4 scale;
+};
+uniform usamplerBuffer clusters;
+uniform usamplerBuffer indices;
+uniform samplerBuffer lights;
+const vec3 Lamb = vec3(0.1, 0.1, 0.1);
+const vec3 Kamb = KAMB;
+const vec3 Kdiff = KDIFF;
+const vec3 Kspec = KSPEC;
+const float Kshi = KSHI;
+in vec4 P;
+in vec3 N;
+layout (location = 0) out vec4 fragment;
+void main() {
+    ivec3 c = ivec3(gl_FragCoord.xy * scale.xy, log(-P.z) * scale.z + scale.w);
+    c = clamp(c, ivec3(0), grid.xyz - 1);
+    uvec2 range = texelFetch(clusters, (c.z * grid.y + c.y) * grid.x + c.x).rg;
+    vec3 n = normalize(N);
+    vec3 V = -normalize(P.xyz);
+    vec3 Idiff = Kamb * Lamb;
+    vec3 Ispec = vec3(0.0);
+    for (uint i = range.x; i < range.x + range.y; ++i) {
+        int l = int(texelFetch(indices, int(i)).r);
+        vec4 Lpos = texelFetch(lights, 2 * l);
+        vec3 Lcolor = texelFetch(lights, 2 * l + 1).rgb;
+        vec3 L = Lpos.xyz - P.xyz;
+        float d = length(L);
+        L /= d;
+        float a = clamp(1.0 - d / Lpos.w, 0.0, 1.0);
+        a *= a;
+        Idiff += a * max(dot(n, L), 0.0) * Kdiff * Lcolor;
+        vec3 H = normalize(L + V);
+        Ispec += a * pow(max(dot(n, H), 0.0), Kshi) * Kspec * Lcolor;
+    }
+    fragment = vec4(Idiff + Ispec, 1.0);
+}
@@ -0,0 +1,83 @@
+#include "VertexLayout.h"
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Vertex attribute in the layout of Object::Vertex, without the OpenGL objects
+struct Vertex {
+    // Position
+    GLfloat position[3];
+
+    // Normal
+    GLfloat normal[3];
+};
+
+// Vertices covering the cases of the quantization
+//   Random positions in a box away from the origin with random unit normals in every octant, the corners of the box
+//   with the axes as normals, and a flat patch whose box has no height
+static std::vector<Vertex> createVertices() {
+    std::vector<Vertex> vertex;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<GLfloat> x(-3.0f, 5.0f), y(-1.0f, 1.0f), z(10.0f, 10.5f);
+    std::normal_distribution<GLfloat> n;
+    for (int k = 0; k < 100000; ++k) {
+        Vertex v{{x(rng), y(rng), z(rng)}, {n(rng), n(rng), n(rng)}};
+        const GLfloat l(std::sqrt(v.normal[0] * v.normal[0] + v.normal[1] * v.normal[1] + v.normal[2] * v.normal[2]));
+        for (GLfloat &c : v.normal) {
+            c /= l;
+        }
+        vertex.push_back(v);
+    }
+    for (int k = 0; k < 8; ++k) {
+        Vertex v{{k & 1 ? 5.0f : -3.0f, k & 2 ? 1.0f : -1.0f, k & 4 ? 10.5f : 10.0f}, {}};
+        v.normal[k % 3] = k & 1 ? 1.0f : -1.0f;
+        vertex.push_back(v);
+    }
+    return vertex;
+}
+
+// Flat patch on the xz plane facing up
+static std::vector<Vertex> createPlane() {
+    std::vector<Vertex> vertex;
+    for (int i = 0; i <= 16; ++i) {
+        for (int j = 0; j <= 16; ++j) {
+            vertex.push_back({{static_cast<GLfloat>(i) / 8.0f - 1.0f, 0.0f, static_cast<GLfloat>(j) / 8.0f - 1.0f},
+                              {0.0f, 1.0f, 0.0f}});
+        }
+    }
+    return vertex;
+}
+
+// Check the quantization error of every layout against the bounds of its formats
+int main() {
+    static constexpr const char *positionName[] = {"float", "half", "snorm16"};
+    static constexpr const char *normalName[] = {"float", "octahedral", "packed"};
+    const std::vector<Vertex> meshes[] = {createVertices(), createPlane()};
+
+    int failures(0);
+    for (int p = 0; p < 3; ++p) {
+        for (int n = 0; n < 3; ++n) {
+            const VertexLayout layout(static_cast<VertexLayout::Position>(p), static_cast<VertexLayout::Normal>(n));
+            const VertexLayout::Error tolerance(layout.getTolerance());
+            for (const std::vector<Vertex> &mesh : meshes) {
+                const VertexLayout::Error error(layout.getError(mesh.data(), mesh.size()));
+                const bool passed(error.position <= tolerance.position && error.normal <= tolerance.normal);
+                std::cout << (passed ? "ok  " : "FAIL") << " positions " << positionName[p] << ", normals "
+                          << normalName[n] << ", " << mesh.size() << " vertices: " << layout.getStride()
+                          << " bytes per vertex, largest error of the positions " << error.position << " (bound "
+                          << tolerance.position << "), of the normals " << error.normal * 57.29578f
+                          << " degrees (bound " << tolerance.normal * 57.29578f << ")" << std::endl;
+                if (!passed) {
+                    ++failures;
+                }
+            }
+        }
+    }
+    if (failures > 0) {
+        std::cerr << "Error: " << failures << " layouts exceed the bounds of their formats" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,169 +1,65 @@
+#include "Bvh.h"
+#include "Frustum.h"
+#include "GlState.h"
+#include "GpuTimer.h"
+#include "InstanceBuffer.h"
+#include "JobSystem.h"
+#include "LodShape.h"
+#include "LightCluster.h"
 #include "Matrix.h"
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+#include "OcclusionBuffer.h"
+#include "ProceduralSphere.h"
+#include "ProgramCache.h"
+#include "Scene.h"
 #include "Shape.h"
 #include "Vector.h"
+#include "VectorArray.h"
 // #include "ShapeIndex.h"
 // #include "SolidShape.h"
 #include "SolidShapeIndex.h"
+#include "SolidShapeStrip.h"
+#include "Trace.h"
+#include "UniformBuffer.h"
 #include "Window.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
 #include <vector>
 
-// Display the compiled result of shader object
-//   shader: Shader object name
-//   str   : String indicating where the compilation error occurred
-GLboolean printShaderInfoLog(GLuint shader, const char *str) {
-    // Get compilation result
-    GLint status;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-    if (status == GL_FALSE) {
-        std::cerr << "Compile Error in " << str << std::endl;
-    }
-
-    // Get log length when shader is compiled
-    GLsizei bufSize;
-    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &bufSize);
-
-    if (bufSize > 1) {
-        // Get log contents
-        std::vector<GLchar> infoLog(bufSize);
-        GLsizei length;
-        glGetShaderInfoLog(shader, bufSize, &length, &infoLog[0]);
-        std::cerr << &infoLog[0] << std::endl;
-    }
-
-    return static_cast<GLboolean>(status);
-}
-
-// Display the link result of program object
-//   program: program object name
-GLboolean printProgramInfoLog(GLuint program) {
-    // Get link result
-    GLint status;
-    glGetProgramiv(program, GL_LINK_STATUS, &status);
-    if (status == GL_FALSE) {
-        std::cerr << "Link Error." << std::endl;
-    }
-
-    // Get log length when linking shader
-    GLsizei bufSize;
-    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &bufSize);
-
-    if (bufSize > 1) {
-        // Get log contents
-        std::vector<GLchar> infoLog(bufSize);
-        GLsizei length;
-        glGetProgramInfoLog(program, bufSize, &length, &infoLog[0]);
-        std::cerr << &infoLog[0] << std::endl;
-    }
-
-    return static_cast<GLboolean>(status);
-}
-
-// Create program object
-//   vsrc: Vertex shader source program string
-//   fsrc: Fragment shader source program string
-GLuint createProgram(const char *vsrc, const char *fsrc) {
-    // Create empty object
-    const GLuint program(glCreateProgram());
-
-    if (vsrc != nullptr) {
-        // Create shader object for vertex shader
-        const GLuint vobj(glCreateShader(GL_VERTEX_SHADER));
-        glShaderSource(vobj, 1, &vsrc, nullptr);
-        glCompileShader(vobj);
-
-        // Embed shader object of vertex shader into program object
-        if (printShaderInfoLog(vobj, "vertex shader")) {
-            glAttachShader(program, vobj);
-        }
-        glDeleteShader(vobj);
-    }
+// Number of light sources, passed to the shaders as LCOUNT
+constexpr int Lcount(2);
 
-    if (fsrc != nullptr) {
-        // Create shader object for fragment shader
-        const GLuint fobj(glCreateShader(GL_FRAGMENT_SHADER));
-        glShaderSource(fobj, 1, &fsrc, nullptr);
-        glCompileShader(fobj);
+// Contents of the uniform block Camera in the std140 layout
+struct Camera {
+    // Projection transformation matrix
+    GLfloat projection[16];
+};
 
-        // Embed shader object of fragment shader into program object
-        if (printShaderInfoLog(fobj, "fragment shader")) {
-            glAttachShader(program, fobj);
-        }
-        glDeleteShader(fobj);
-    }
-
-    // Link program object
-    glBindAttribLocation(program, 0, "position");
-    glBindAttribLocation(program, 1, "normal");
-    glBindFragDataLocation(program, 0, "fragment");
-    glLinkProgram(program);
-
-    // Return created program object
-    if (printProgramInfoLog(program)) {
-        return program;
-    }
-
-    // Return 0, if program object cannot be created
-    glDeleteProgram(program);
-    return 0;
-}
-
-// Returns the memory from which the shader source file was loaded
-//   name  : Shader source file name
-//   buffer: Text of the loaded source file
-bool readShaderSource(const char *name, std::vector<GLchar> &buffer) {
-    if (name == nullptr) {
-        return false;
-    }
-
-    std::ifstream file(name, std::ios::binary);
-    if (file.fail()) {
-        std::cerr << "Error: Can't open source file: " << name << std::endl;
-        return false;
-    }
-
-    // Move to the end of the file and get the current position(= file size)
-    file.seekg(0L, std::ios::end);
-    GLsizei length = static_cast<GLsizei>(file.tellg());
-
-    // Allocate file size memory
-    buffer.resize(length + 1);
-
-    // Read the file from the beginning
-    file.seekg(0L, std::ios::beg);
-    file.read(buffer.data(), length);
-    buffer[length] = '\0';
-
-    if (file.fail()) {
-        std::cerr << "Error: Could not read source file: " << name << std::endl;
-        file.close();
-        return false;
-    }
-
-    // Read success
-    file.close();
-    return true;
-}
-
-// Read shader source file and create program object
-//   vert: Vertex shader source file name
-//   frag: Source file name of the fragment shader
-bool loadProgram(const char *vert, const char *frag) {
-    // Load shader source file
-    std::vector<GLchar> vsrc;
-    const bool vstat(readShaderSource(vert, vsrc));
-    std::vector<GLchar> fsrc;
-    const bool fstat(readShaderSource(frag, fsrc));
-
-    // Create program object
-    return vstat && fstat && createProgram(vsrc.data(), fsrc.data());
-}
+// Contents of the uniform block Light in the std140 layout, each array element takes a vec4
+struct Light {
+    // Positions in the eye coordinate system
+    GLfloat Lpos[Lcount][4];
+    // Ambient, diffuse and specular intensities
+    GLfloat Lamb[Lcount][4];
+    GLfloat Ldiff[Lcount][4];
+    GLfloat Lspec[Lcount][4];
+};
 
 // Vertex attributes of a hexahedron with a different normal for each face
 // constexpr Object::Vertex solidCubeVertex[] = {
@@ -220,161 +116,980 @@ bool loadProgram(const char *vert, const char *frag) {
 //     30, 31, 32, 33, 34, 35  // Front
 // };
 
-int main() {
-    // Initialize GLFW
-    if (glfwInit() == GL_FALSE) {
-        std::cerr << "Can't initialize GLFW" << std::endl;
+int main(int argc, char *argv[]) {
+    // Command line options
+    //   --headless    : Render offscreen without a display and report the frame rate
+    //   --size WxH    : Size of the offscreen frame buffer
+    //   --frames count: Number of frames rendered offscreen
+    //   --gpu-timing  : Measure the GPU time of each drawing pass and report it at the end
+    //   --gpu-csv file: Also write every sample of the GPU time to a CSV file
+    //   --trace file  : Write the CPU trace in the Chrome trace_event JSON format (debug builds only)
+    //   --no-instancing: Draw each sphere with its own draw call and uniform variables
+    //   --lights count : Light the spheres per fragment with the given number of point lights assigned to clusters
+    //   --light-sweep  : Draw with 2, 4, ... 1024 clustered lights in turn offscreen and report the time of each
+    //   --per-fragment : Compute the lighting of the two light sources per fragment instead of per vertex
+    //   --lambert      : Leave out the specular reflection
+    //   --program-cache directory: Keep the linked program binaries in a directory to skip compiling on later launches
+    //   --mesh name    : Shape drawn, sphere, cube, torus, cylinder or plane
+    //   --divisions NxM: Number of divisions of the shape, only N is used for the cube
+    //   --procedural   : Generate the sphere in the vertex shader without vertex buffers
+    //   --lod          : Switch among coarser tessellations of the shape by its size on the screen
+    //   --scene count  : Scatter more shapes around the two spheres, most of them outside the view, and cull them
+    //   --pick X,Y     : Pick the object under a point in normalized device coordinates every frame like a right click
+    //   --occlusion count: Hide the objects behind the given number of nearest ones rasterized on the CPU
+    //   --jobs count     : Number of threads preparing the drawing, every hardware thread by default
+    //   --load file      : Draw a mesh file written by meshconv, or an OBJ or PLY file, instead of a procedural mesh
+    //   --positions format: Store the vertex positions as float, half or snorm16
+    //   --normals format  : Store the vertex normals as float, octahedral or packed
+    //   --optimize        : Reorder the triangles and the vertices of the meshes for the caches of the GPU
+    //   --strips          : Also join the triangles into strips separated by the primitive restart index
+    //   --bench-vectors count: Compare the batch transform of count vectors with transforming them one at a time
+    bool headless(false);
+    Window::Offscreen offscreen{640, 480, 600};
+    bool gpuTiming(false);
+    const char *gpuCsv(nullptr);
+    const char *traceFile(nullptr);
+    bool instancing(true);
+    int clusteredLights(0);
+    bool lightSweep(false);
+    bool perFragment(false);
+    bool specular(true);
+    const char *programCache(nullptr);
+    std::string_view meshName("sphere");
+    int divisions[2]{16, 8};
+    bool procedural(false);
+    bool lod(false);
+    int sceneCount(0);
+    bool pickEveryFrame(false);
+    GLfloat pickPoint[2]{};
+    std::size_t occluderCount(0);
+    unsigned jobCount(0);
+    const char *meshPath(nullptr);
+    VertexLayout::Position positionFormat(VertexLayout::Position::Float);
+    VertexLayout::Normal normalFormat(VertexLayout::Normal::Float);
+    bool optimize(false);
+    bool strips(false);
+    std::size_t benchVectors(0);
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--size" && i + 1 < argc) {
+            std::sscanf(argv[++i], "%dx%d", &offscreen.width, &offscreen.height);
+        } else if (arg == "--frames" && i + 1 < argc) {
+            offscreen.frames = std::atoi(argv[++i]);
+        } else if (arg == "--gpu-timing") {
+            gpuTiming = true;
+        } else if (arg == "--gpu-csv" && i + 1 < argc) {
+            gpuTiming = true;
+            gpuCsv = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (arg == "--no-instancing") {
+            instancing = false;
+        } else if (arg == "--lights" && i + 1 < argc) {
+            clusteredLights = std::atoi(argv[++i]);
+        } else if (arg == "--light-sweep") {
+            lightSweep = true;
+        } else if (arg == "--per-fragment") {
+            perFragment = true;
+        } else if (arg == "--lambert") {
+            specular = false;
+        } else if (arg == "--program-cache" && i + 1 < argc) {
+            programCache = argv[++i];
+        } else if (arg == "--mesh" && i + 1 < argc && Mesh::isShape(argv[i + 1])) {
+            meshName = argv[++i];
+        } else if (arg == "--divisions" && i + 1 < argc) {
+            std::sscanf(argv[++i], "%dx%d", &divisions[0], &divisions[1]);
+        } else if (arg == "--procedural") {
+            procedural = true;
+        } else if (arg == "--lod") {
+            lod = true;
+        } else if (arg == "--scene" && i + 1 < argc) {
+            sceneCount = std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "--pick" && i + 1 < argc) {
+            pickEveryFrame = std::sscanf(argv[++i], "%f,%f", &pickPoint[0], &pickPoint[1]) == 2;
+        } else if (arg == "--occlusion" && i + 1 < argc) {
+            occluderCount = static_cast<std::size_t>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobCount = static_cast<unsigned>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--load" && i + 1 < argc) {
+            meshPath = argv[++i];
+        } else if (arg == "--positions" && i + 1 < argc &&
+                   (argv[i + 1] == std::string_view("float") || argv[i + 1] == std::string_view("half") ||
+                    argv[i + 1] == std::string_view("snorm16"))) {
+            const std::string_view format(argv[++i]);
+            positionFormat = format == "half"      ? VertexLayout::Position::Half
+                             : format == "snorm16" ? VertexLayout::Position::Snorm16
+                                                   : VertexLayout::Position::Float;
+        } else if (arg == "--normals" && i + 1 < argc &&
+                   (argv[i + 1] == std::string_view("float") || argv[i + 1] == std::string_view("octahedral") ||
+                    argv[i + 1] == std::string_view("packed"))) {
+            const std::string_view format(argv[++i]);
+            normalFormat = format == "octahedral" ? VertexLayout::Normal::Octahedral
+                           : format == "packed"   ? VertexLayout::Normal::Packed
+                                                  : VertexLayout::Normal::Float;
+        } else if (arg == "--optimize") {
+            optimize = true;
+        } else if (arg == "--strips") {
+            optimize = strips = true;
+        } else if (arg == "--bench-vectors" && i + 1 < argc) {
+            benchVectors = static_cast<std::size_t>(std::max(std::atoi(argv[++i]), 0));
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--headless] [--size WxH] [--frames count] [--gpu-timing] [--gpu-csv file] [--trace file]"
+                      << " [--no-instancing] [--lights count] [--light-sweep] [--per-fragment] [--lambert]"
+                      << " [--program-cache directory] [--mesh sphere|cube|torus|cylinder|plane] [--divisions NxM]"
+                      << " [--procedural] [--lod] [--scene count] [--pick X,Y]"
+                      << " [--occlusion count] [--jobs count] [--load file] [--positions format] [--normals format]"
+                      << " [--optimize] [--strips] [--bench-vectors count]" << std::endl;
+            return 1;
+        }
     }
 
-    // Register processing at the end of program
-    atexit(glfwTerminate);
+    // The sweep draws a fixed number of frames offscreen, and takes its lights from the largest count
+    if (lightSweep && !headless) {
+        std::cerr << "The light sweep only runs offscreen with --headless." << std::endl;
+        lightSweep = false;
+    }
+    if (lightSweep) {
+        clusteredLights = 1024;
+    }
+
+    if (!headless) {
+        TRACE_SCOPE("glfwInit");
 
-    // Select OpenGL version 3.2 Core Profile
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        // Initialize GLFW
+        if (glfwInit() == GL_FALSE) {
+            std::cerr << "Can't initialize GLFW" << std::endl;
+        }
 
-    Window window;
+        // Register processing at the end of program
+        atexit(glfwTerminate);
+
+        // Select OpenGL version 3.2 Core Profile
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    }
+
+    // Open the window, or the offscreen frame buffer
+    const std::unique_ptr<Window> windowPtr(headless ? new Window(offscreen) : new Window());
+    Window &window(*windowPtr);
+
+    // Program objects specialized for the features used, their source files are read while the rest is set up
+    ProgramCache programs;
+    programs.prefetch({"point.vert", "point.frag", "cluster.frag"});
 
     // Set background color
     glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
 
     // Enable back-culling
-    glFrontFace(GL_CCW);
-    glCullFace(GL_BACK);
-    glEnable(GL_CULL_FACE);
+    GlState::frontFace(GL_CCW);
+    GlState::cullFace(GL_BACK);
+    GlState::enable(GL_CULL_FACE);
 
     // Enable depth-buffer
     glClearDepth(1.0);
-    glDepthFunc(GL_LESS);
-    glEnable(GL_DEPTH_TEST);
+    GlState::depthFunc(GL_LESS);
+    GlState::enable(GL_DEPTH_TEST);
 
-    // Create program object
-    const GLuint program(loadProgram("point.vert", "point.frag"));
+    // Uniform buffer objects of the camera and light data shared by all program objects
+    UniformBuffer<Camera> camera(0);
+    UniformBuffer<Light> light(1);
 
-    // Get uniform variable location
-    const GLint modelviewLoc(glGetUniformLocation(program, "modelview"));
-    const GLint projectionLoc(glGetUniformLocation(program, "projection"));
-    const GLint normalMatrixLoc(glGetUniformLocation(program, "normalMatrix"));
-    const GLint LposLoc(glGetUniformLocation(program, "Lpos"));
-    const GLint LambLoc(glGetUniformLocation(program, "Lamb"));
-    const GLint LdiffLoc(glGetUniformLocation(program, "Ldiff"));
-    const GLint LspecLoc(glGetUniformLocation(program, "Lspec"));
-
-    // Number of sphere divisions
-    const int slices(16), stacks(8);
-
-    // Create vertex attributes
-    std::vector<Object::Vertex> solidSphereVertex;
-    for (int j = 0; j <= stacks; ++j) {
-        const float t(static_cast<float>(j) / static_cast<float>(stacks));
-        const float y(cos(3.141593f * t)), r(sin(3.141593f * t));
-        for (int i = 0; i <= slices; ++i) {
-            const float s(static_cast<float>(i) / static_cast<float>(slices));
-            const float z(r * cos(6.283185f * s)), x(r * sin(6.283185f * s));
-            // Vertex attributes
-            const Object::Vertex v = {{x, y, z}, {x, y, z}};
-            // Add vertex attributes
-            solidSphereVertex.emplace_back(v);
+    // Connect the program objects to the uniform blocks when they are built
+    programs.setInitializer([&](GLuint p) {
+        camera.bind(p, "Camera");
+        light.bind(p, "Light");
+    });
+
+    // Load the program objects built by an earlier launch
+    std::unique_ptr<ProgramBinaryCache> binaries;
+    if (programCache != nullptr) {
+        binaries.reset(new ProgramBinaryCache(programCache));
+        if (!*binaries) {
+            std::cerr << "Program binary is not supported." << std::endl;
+        }
+        programs.setBinaryCache(binaries.get());
+    }
+
+    // Features of the lighting common to all variants
+    ProgramCache::Defines lighting{{"LCOUNT", std::to_string(Lcount)}};
+    lighting["PER_FRAGMENT"] = perFragment ? "1" : "0";
+    lighting["SPECULAR"] = specular ? "1" : "0";
+    lighting["PROCEDURAL"] = procedural ? "1" : "0";
+
+    // Variant for instanced drawing
+    ProgramCache::Defines instanced(lighting);
+    instanced["INSTANCING"] = "1";
+
+    // Variant for clustered lighting
+    const ProgramCache::Defines clustered{
+        {"INSTANCING", "1"}, {"PER_FRAGMENT", "1"}, {"PROCEDURAL", procedural ? "1" : "0"}};
+
+    // Submit all variants at once, so that the driver can compile them in parallel while the meshes are made
+    programs.request("point.vert", "point.frag", lighting);
+    programs.request("point.vert", "point.frag", instanced);
+    if (clusteredLights > 0) {
+        programs.request("point.vert", "cluster.frag", clustered);
+    }
+
+    // Per-instance attributes of the spheres
+    InstanceBuffer instances(2);
+
+    if (procedural && meshName != "sphere") {
+        std::cerr << "Only the sphere can be generated in the vertex shader." << std::endl;
+    }
+
+    // Threads making the meshes and preparing the drawing, the main thread only issues the OpenGL commands after them
+    JobSystem jobs(jobCount);
+
+    // Layout of the vertex attributes of the shapes, compact ones quantized when uploaded
+    const VertexLayout layout(positionFormat, normalFormat);
+
+    // Create graphic data of a mesh reordered for the caches of the GPU, and report the average cache miss ratio
+    //   vertex: Vertex attributes, reordered in place
+    //   index : Indices of the triangles, reordered in place
+    const auto createOptimized([&](std::vector<Object::Vertex> &vertex, std::vector<GLuint> &index) -> const Shape * {
+        const double before(MeshOptimizer::getAcmr(index, vertex.size()));
+        MeshOptimizer::optimizeCache(index, vertex.size());
+        MeshOptimizer::optimizeFetch(vertex, index);
+        const GLsizei vertexCount(static_cast<GLsizei>(vertex.size()));
+        if (headless) {
+            std::cout << index.size() / 3 << " triangles, average cache miss ratio " << before << " -> "
+                      << MeshOptimizer::getAcmr(index, vertex.size()) << ", "
+                      << Object::getIndexSize(vertexCount) * 8 << "-bit indices" << std::endl;
+        }
+        if (!strips) {
+            return new SolidShapeIndex(3, vertexCount, vertex.data(), static_cast<GLsizei>(index.size()),
+                                       index.data(), layout);
+        }
+
+        // The strips need fewer indices than the triangles
+        const std::vector<GLuint> strip(MeshOptimizer::stripify(index));
+        if (headless) {
+            std::cout << strip.size() << " strip indices instead of " << index.size() << std::endl;
+        }
+        return new SolidShapeStrip(3, vertexCount, vertex.data(), static_cast<GLsizei>(strip.size()), strip.data(),
+                                   layout);
+    });
+
+    // Create graphic data of a tessellation, a mesh is generated directly into the buffer objects
+    //   n, m     : Number of divisions
+    //   triangles: Number of triangles of the shape
+    const auto createShape([&](int n, int m, std::size_t &triangles) -> const Shape * {
+        // The vertex shader generates the sphere
+        if (procedural) {
+            triangles = static_cast<std::size_t>(n) * m * 2;
+            return new ProceduralSphere(n, m);
+        }
+
+        // Procedural mesh
+        const std::unique_ptr<const Mesh> mesh(Mesh::create(meshName, n, m));
+        triangles = mesh->getTriangleCount();
+
+        // The mesh is reordered on the CPU before it is uploaded
+        if (optimize) {
+            std::vector<Object::Vertex> vertex(mesh->getVertexCount());
+            std::vector<GLuint> index(mesh->getIndexCount());
+            mesh->generate(vertex.data(), index.data(), jobs);
+            return createOptimized(vertex, index);
+        }
+        return new SolidShapeIndex(3, mesh->getVertexCount(), mesh->getIndexCount(), mesh->fill(jobs), layout);
+    });
+
+    // Mesh file mapped into memory or mesh imported from an OBJ or PLY file, which are only needed until uploaded
+    std::unique_ptr<MeshFile> meshFile;
+    std::unique_ptr<MeshImporter> importer;
+    if (meshPath != nullptr) {
+        const auto start(std::chrono::steady_clock::now());
+        if (std::string_view(meshPath).ends_with(".mesh")) {
+            meshFile.reset(new MeshFile(meshPath));
+            if (!*meshFile) {
+                return 1;
+            }
+        } else {
+            importer.reset(new MeshImporter(jobs));
+            if (!importer->load(meshPath)) {
+                return 1;
+            }
+        }
+        if (lod || procedural || occluderCount > 0) {
+            std::cerr << "A mesh file is drawn without levels of detail, procedural generation and occlusion culling."
+                      << std::endl;
+            lod = procedural = false;
+            occluderCount = 0;
+        }
+        const std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+        if (headless) {
+            std::cout << "mesh file " << (meshFile ? "mapped" : "imported") << " in " << elapsed.count() * 1000.0
+                      << " ms" << std::endl;
+        }
+    }
+
+    // Radius of the bounding sphere of the shape
+    const GLfloat boundingRadius(meshFile                              ? meshFile->getRadius()
+                                 : importer                            ? importer->getRadius()
+                                 : procedural || meshName == "sphere" ? 1.0f
+                                                                      : 1.732051f);
+
+    // Levels of detail of the shape drawn for both spheres, halving the divisions at each level
+    LodShape shape;
+    if (meshFile || importer) {
+        // The buffer objects are filled straight from the mapped pages or the imported arrays
+        TRACE_SCOPE("mesh");
+        const auto start(std::chrono::steady_clock::now());
+        const GLsizei vertexCount(meshFile ? meshFile->getVertexCount()
+                                           : static_cast<GLsizei>(importer->getVertices().size()));
+        const GLsizei indexCount(meshFile ? meshFile->getIndexCount()
+                                          : static_cast<GLsizei>(importer->getIndices().size()));
+        const std::size_t triangles(indexCount / 3);
+        const Object::Vertex *const vertices(meshFile ? meshFile->getVertices() : importer->getVertices().data());
+        const GLuint *const indices(meshFile ? meshFile->getIndices() : importer->getIndices().data());
+        if (optimize) {
+            std::vector<Object::Vertex> vertex(vertices, vertices + vertexCount);
+            std::vector<GLuint> index(indices, indices + indexCount);
+            shape.addLevel(createOptimized(vertex, index), 0.0f, triangles);
+        } else {
+            shape.addLevel(new SolidShapeIndex(3, vertexCount, vertices, indexCount, indices, layout), 0.0f,
+                           triangles);
+        }
+        meshFile.reset();
+        importer.reset();
+        const std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+        if (headless) {
+            std::cout << triangles << " triangles uploaded in " << elapsed.count() * 1000.0 << " ms" << std::endl;
+        }
+    } else {
+        TRACE_SCOPE("mesh");
+        const auto start(std::chrono::steady_clock::now());
+        const int levels(lod ? 4 : 1);
+        std::size_t total(0);
+        for (int k = 0; k < levels; ++k) {
+            const int n(std::max(divisions[0] >> k, 4)), m(std::max(divisions[1] >> k, 2));
+            std::size_t triangles;
+            const Shape *const s(createShape(n, m, triangles));
+
+            // A level is drawn while the next one would have edges longer than 8 pixels around the circumference
+            const GLfloat next(static_cast<GLfloat>(std::max(divisions[0] >> (k + 1), 4)));
+            shape.addLevel(s, k + 1 < levels ? next * 8.0f / 6.283185f : 0.0f, triangles);
+            total += triangles;
+        }
+        const std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+        if (headless && !procedural) {
+            std::cout << total << " triangles in " << elapsed.count() * 1000.0 << " ms ("
+                      << static_cast<double>(total) / elapsed.count() * 1.0e-6 << " M triangles/s)" << std::endl;
+        }
+    }
+
+    // Calculate the view transformation matrix at compile time
+    static constexpr RigidMatrix view(RigidMatrix::lookat(3.0f, 4.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f));
+
+    // Viewpoint in the world coordinate system to find the nearest objects
+    static constexpr RigidMatrix eye(view.inverse());
+
+    // Number of objects, the two spheres come first and the rest of the scene does not move
+    const std::size_t objectCount(2 + sceneCount);
+
+    // Transformations of the objects, the second sphere hangs on the first one and the rest of the scene is scattered
+    // with a fixed seed so that the results are reproducible
+    Scene scene(view);
+    scene.setJobSystem(&jobs);
+    scene.add(RigidMatrix::identity());
+    scene.add(RigidMatrix::translate(0.0f, 0.0f, 3.0f), 0);
+    {
+        std::mt19937 rng(2);
+        std::uniform_real_distribution<GLfloat> position(-20.0f, 20.0f), angle(0.0f, 6.283185f);
+        for (int i = 0; i < sceneCount; ++i) {
+            const GLfloat x(position(rng)), y(position(rng)), z(position(rng));
+            scene.add(RigidMatrix::translate(x, y, z) * RigidMatrix::rotate(angle(rng), 0.0f, 1.0f, 0.0f));
         }
     }
+    scene.update();
+    std::size_t updatedObjects(0);
 
-    // Create indices
-    std::vector<GLuint> solidSphereIndex;
-    for (int j = 0; j < stacks; ++j) {
-        const int k((slices + 1) * j);
-        for (int i = 0; i < slices; ++i) {
-            // Vertex index
-            const GLuint k0(k + i);
-            const GLuint k1(k0 + 1);
-            const GLuint k2(k1 + slices);
-            const GLuint k3(k2 + 1);
-            // Bottom left triangle
-            solidSphereIndex.emplace_back(k0);
-            solidSphereIndex.emplace_back(k2);
-            solidSphereIndex.emplace_back(k3);
-            // Upper right triangle
-            solidSphereIndex.emplace_back(k0);
-            solidSphereIndex.emplace_back(k3);
-            solidSphereIndex.emplace_back(k1);
+    // Bounding spheres of the objects in the world coordinate system, the radius is in w
+    VectorArray bounds(objectCount);
+    for (std::uint32_t i = 0; i < objectCount; ++i) {
+        const RigidMatrix &m(scene.getWorld(i));
+        bounds.set(i, {m[12], m[13], m[14], boundingRadius});
+    }
+
+    // Hierarchy of the bounding spheres for picking, refitted to the objects that move
+    Bvh bvh;
+    if (!headless || pickEveryFrame) {
+        const auto start(std::chrono::steady_clock::now());
+        bvh.build(bounds.span());
+        if (sceneCount > 0) {
+            std::cout << "BVH of " << objectCount << " objects in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms (" << bvh.size() << " nodes)" << std::endl;
+        }
+    }
+
+    // Time spent picking, the number of picks, and the last object picked
+    std::chrono::steady_clock::duration pickTime{};
+    long picks(0);
+    Bvh::Hit picked{};
+    bool pickedAny(false);
+
+    // Depth buffer of the occluders, which are coarse tessellations of the shape shrunk to lie inside every level drawn
+    std::unique_ptr<OcclusionBuffer> occlusion;
+    std::vector<Object::Vertex> occluderVertex;
+    std::vector<GLuint> occluderIndex;
+    std::vector<std::uint32_t> occluders;
+    if (occluderCount > 0) {
+        // The faces of the coarsest level come within cos(pi / n) of the radius around the axis, and quantized
+        // positions move by the tolerance of each component of the half size of the box
+        const int n(std::max(divisions[0] >> (lod ? 3 : 0), 4)), m(std::max(divisions[1] >> (lod ? 3 : 0), 2));
+        const GLfloat around(std::cos(3.141593f / static_cast<GLfloat>(n)));
+        const GLfloat slack(1.732051f * layout.getTolerance().position * boundingRadius);
+        std::unique_ptr<const Mesh> mesh;
+        GLfloat scale(1.0f);
+        if (procedural || meshName == "sphere") {
+            // Distance to the plane of each band of faces, through the middles of its edges on the bisecting meridian
+            for (int j = 0; j < m; ++j) {
+                const GLfloat t1(3.141593f * static_cast<GLfloat>(j) / static_cast<GLfloat>(m));
+                const GLfloat t2(3.141593f * static_cast<GLfloat>(j + 1) / static_cast<GLfloat>(m));
+                const GLfloat dx(around * (std::sin(t1) - std::sin(t2))), dy(std::cos(t1) - std::cos(t2));
+                scale = std::min(scale, around * std::sin(t2 - t1) / std::sqrt(dx * dx + dy * dy));
+            }
+            scale -= slack;
+            mesh.reset(new SphereMesh(8, 4));
+        } else if (meshName == "cube") {
+            scale -= slack;
+            mesh.reset(new CubeMesh(1));
+        } else if (meshName == "cylinder") {
+            mesh.reset(new CylinderMesh(8, 1, around - slack, 2.0f - 2.0f * slack));
+        } else if (meshName == "torus") {
+            // The faces come within the tube times cos(pi / m) of the circle in the tube, less the (1 - cos(pi / n)) of
+            // the outer radius that the chords around the axis cut inward, and the chords of the occluder cut inward
+            // likewise
+            const GLfloat inner(0.25f * std::cos(3.141593f / static_cast<GLfloat>(m)) - (1.0f - around) * 1.25f -
+                                slack);
+            const GLfloat c(std::cos(3.141593f / 16.0f)), tube((inner - (1.0f - c)) / (2.0f - c));
+            if (tube > 0.0f) {
+                mesh.reset(new TorusMesh(16, 4, 1.0f, tube));
+            }
+        } else {
+            mesh.reset(new PlaneMesh(1, 1));
+        }
+        if (mesh) {
+            occlusion.reset(new OcclusionBuffer());
+            occlusion->setJobSystem(&jobs);
+            occluderVertex.resize(mesh->getVertexCount());
+            occluderIndex.resize(mesh->getIndexCount());
+            mesh->generate(occluderVertex.data(), occluderIndex.data(), jobs);
+            for (Object::Vertex &v : occluderVertex) {
+                for (GLfloat &p : v.position) {
+                    p *= scale;
+                }
+            }
+        } else {
+            std::cerr << "The torus is drawn too coarsely for an occluder inside it, occlusion culling is off."
+                      << std::endl;
+            occluderCount = 0;
         }
     }
 
-    // Create graphic data
-    std::unique_ptr<const Shape> shape(
-        new SolidShapeIndex(3, static_cast<GLsizei>(solidSphereVertex.size()), solidSphereVertex.data(),
-                            static_cast<GLsizei>(solidSphereIndex.size()), solidSphereIndex.data()));
+    // Time spent on occlusion culling and the objects hidden
+    std::chrono::steady_clock::duration occlusionTime{};
+    std::size_t occludedObjects(0);
+
+    // Indices of the visible objects, and the time spent culling
+    std::vector<std::uint32_t> visible(objectCount);
+    std::chrono::steady_clock::duration cullTime{};
+    std::size_t visibleObjects(0);
+
+    // Levels of the objects in the previous frame, and the number of triangles drawn
+    std::vector<int> level(objectCount, -1);
+    std::size_t drawnTriangles(0);
+    long drawnFrames(0);
+
+    // State calls of all frames, the ones made while setting up are left out
+    GlState::Counters stateCalls{};
+    GlState::endFrame();
+
+    // Visible objects grouped by level, where each level starts, and their instance attributes
+    std::vector<std::uint32_t> byLevel(objectCount);
+    std::vector<std::size_t> levelStart;
+    std::vector<InstanceBuffer::Instance> batch;
+
+    // Time spent preparing the drawing of the visible objects
+    std::chrono::steady_clock::duration prepareTime{};
+
+    // Create program object
+    const GLuint program(programs.get("point.vert", "point.frag", lighting));
+
+    // Get uniform variable location
+    const GLint modelviewLoc(glGetUniformLocation(program, "modelview"));
+    const GLint normalMatrixLoc(glGetUniformLocation(program, "normalMatrix"));
+
+    // Program object for instanced drawing, used once the driver has built it
+    GLuint instanceProgram(programs.find("point.vert", "point.frag", instanced));
 
     // Light source data
-    static constexpr int Lcount(2);
     static constexpr Vector Lpos[] = {{0.0f, 0.0f, 5.0f, 1.0f}, {8.0f, 0.0f, 0.0f, 1.0f}};
     static constexpr GLfloat Lamb[] = {0.2f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f};
     static constexpr GLfloat Ldiff[] = {1.0f, 0.5f, 0.5f, 0.9f, 0.9f, 0.9f};
     static constexpr GLfloat Lspec[] = {1.0f, 0.5f, 0.5f, 0.9f, 0.9f, 0.9f};
 
+    // Transform the light positions to the eye coordinate system at once, since the view does not change
+    VectorArray LposArray(Lpos, Lpos + Lcount);
+    transform(view, LposArray.span(), LposArray.span());
+
+    // Measure the batch transform against the matrix times each vector, taking the best of a few runs of each
+    if (headless && benchVectors > 0) {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<GLfloat> position(-10.0f, 10.0f);
+        VectorArray in(benchVectors), batched(benchVectors);
+        for (std::size_t i = 0; i < benchVectors; ++i) {
+            in.set(i, {position(rng), position(rng), position(rng), 1.0f});
+        }
+        std::vector<Vector> single(benchVectors);
+
+        // A projective matrix, whose every row is computed
+        const Matrix m(Matrix::perspective(1.0f, 4.0f / 3.0f, 1.0f, 10.0f) * view);
+        const auto best([](const auto &f) {
+            double seconds(HUGE_VAL);
+            for (int run = 0; run < 5; ++run) {
+                const auto start(std::chrono::steady_clock::now());
+                f();
+                const std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+                seconds = std::min(seconds, elapsed.count());
+            }
+            return seconds;
+        });
+        const double batchTime(best([&] { transform(m, in.span(), batched.span()); }));
+        const double singleTime(best([&] {
+            for (std::size_t i = 0; i < benchVectors; ++i) {
+                single[i] = m * in[i];
+            }
+        }));
+
+        // Largest difference of the results relative to their size
+        GLfloat difference(0.0f);
+        for (std::size_t i = 0; i < benchVectors; ++i) {
+            const Vector b(batched[i]);
+            for (int j = 0; j < 4; ++j) {
+                difference = std::max(difference, std::abs(b[j] - single[i][j]) / (std::abs(single[i][j]) + 1.0f));
+            }
+        }
+        std::cout << "vectors: " << benchVectors / batchTime * 1.0e-6 << " M/s batched, "
+                  << benchVectors / singleTime * 1.0e-6 << " M/s one at a time, largest difference " << difference
+                  << std::endl;
+    }
+
+    // Set the light data to the uniform buffer object once, since it does not change either
+    Light lightData{};
+    for (int i = 0; i < Lcount; ++i) {
+        const Vector p(LposArray[i]);
+        std::copy(p.begin(), p.end(), lightData.Lpos[i]);
+        std::copy(Lamb + 3 * i, Lamb + 3 * i + 3, lightData.Lamb[i]);
+        std::copy(Ldiff + 3 * i, Ldiff + 3 * i + 3, lightData.Ldiff[i]);
+        std::copy(Lspec + 3 * i, Lspec + 3 * i + 3, lightData.Lspec[i]);
+    }
+    light.set(lightData);
+
+    // Clustered per-fragment lighting with many point lights
+    std::unique_ptr<LightCluster> lightCluster;
+    std::vector<PointLight> pointLights;
+    GLuint clusterProgram(0);
+    if (clusteredLights > 0) {
+        lightCluster.reset(new LightCluster(16, 8, 24, 2, 1));
+
+        // The sweep measures the clustered drawing from its first frame, so it waits for the program
+        clusterProgram = lightSweep ? programs.get("point.vert", "cluster.frag", clustered)
+                                    : programs.find("point.vert", "cluster.frag", clustered);
+        if (clusterProgram != 0) {
+            lightCluster->bind(clusterProgram);
+        }
+
+        // Scatter the lights around the spheres with a fixed seed so that the results are reproducible
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<GLfloat> position(-3.0f, 3.0f), color(0.2f, 1.0f);
+        VectorArray positions(clusteredLights);
+        for (int i = 0; i < clusteredLights; ++i) {
+            positions.set(i, {position(rng), position(rng), position(rng) + 1.5f, 1.0f});
+        }
+
+        // Lights are in the eye coordinate system, which does not change
+        transform(view, positions.span(), positions.span());
+        pointLights.resize(clusteredLights);
+        for (int i = 0; i < clusteredLights; ++i) {
+            const Vector p(positions[i]);
+            pointLights[i] = {{p[0], p[1], p[2]}, 2.0f, {color(rng), color(rng), color(rng), 1.0f}};
+        }
+        lightCluster->setLights(pointLights.data(), pointLights.size());
+    }
+
+    // Measurement of the GPU time of each drawing pass
+    GpuTimer timer(gpuTiming);
+    if (gpuTiming && !timer) {
+        std::cerr << "Timer query is not supported." << std::endl;
+    }
+    std::ofstream csv;
+    if (timer && gpuCsv != nullptr) {
+        csv.open(gpuCsv);
+        timer.setCsv(&csv);
+    }
+
+    // Whether some variants may still be being built in the background
+    bool building(true);
+
+    // Whether the time spent building the program objects has been printed, once all of them are built
+    bool reported(!headless && programCache == nullptr);
+
     // Set timer 0
-    glfwSetTime(0.0);
+    if (!headless) {
+        glfwSetTime(0.0);
+    }
+
+    // Perspective projection transformation matrix, and the window size and scale it was made for
+    Matrix projection;
+    GLfloat projectionSize[2]{}, projectionScale(0.0f);
+
+    // Numbers of lights of the sweep, the frames drawn with each and the time they took
+    static constexpr int sweepCounts[] = {2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+    const long sweepFrames(std::max(offscreen.frames / static_cast<int>(std::size(sweepCounts)), 1));
+    std::vector<double> sweepTimes;
+    auto sweepStart(std::chrono::steady_clock::now());
+    long sweepFrame(0);
 
     // Repeat while the window is open
     while (window) {
+        TRACE_SCOPE("frame");
+
+        // Switch to the instanced variants once the driver has built them, drawing each object until then
+        if (building) {
+            building = programs.poll() > 0;
+            instanceProgram = programs.find("point.vert", "point.frag", instanced);
+            if (lightCluster && clusterProgram == 0) {
+                clusterProgram = programs.find("point.vert", "cluster.frag", clustered);
+                if (clusterProgram != 0) {
+                    lightCluster->bind(clusterProgram);
+                }
+            }
+        }
+
+        // Time spent building the program objects, to compare launches with and without the binary cache
+        if (!building && !reported) {
+            programs.report(std::cout);
+            reported = true;
+        }
+
+        // Move to the next number of lights once the frames of the previous one are finished
+        bool lightsChanged(false);
+        if (lightSweep && sweepFrame++ % sweepFrames == 0 && sweepTimes.size() < std::size(sweepCounts)) {
+            glFinish();
+            const auto now(std::chrono::steady_clock::now());
+            if (sweepFrame > 1) {
+                sweepTimes.push_back(std::chrono::duration<double, std::milli>(now - sweepStart).count() / sweepFrames);
+            }
+            if (sweepTimes.size() < std::size(sweepCounts)) {
+                lightCluster->setLights(pointLights.data(), sweepCounts[sweepTimes.size()]);
+                lightsChanged = true;
+            }
+            sweepStart = now;
+        }
+
+        // Start measuring the frame
+        timer.beginFrame();
+
         // Clear the window
+        timer.begin("clear");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        timer.end();
+
+        // Transformation matrices of this frame
+        bool projectionChanged(false);
+        {
+            TRACE_SCOPE("transforms");
 
-        // Start using shader program
-        glUseProgram(program);
+            // Calculate the perspective projection transformation matrix only when the window has changed
+            const GLfloat *const size(window.getSize());
+            if (size[0] != projectionSize[0] || size[1] != projectionSize[1] || window.getScale() != projectionScale) {
+                projectionSize[0] = size[0];
+                projectionSize[1] = size[1];
+                projectionScale = window.getScale();
+                const GLfloat fovy(projectionScale * 0.01f);
+                const GLfloat aspect(size[0] / size[1]);
+                projection = Matrix::perspective(fovy, aspect, 1.0f, 10.0f);
+                projectionChanged = true;
+            }
 
-        // Calculate the perspective projection transformation matrix
-        const GLfloat *const size(window.getSize());
-        const GLfloat fovy(window.getScale() * 0.01f);
-        const GLfloat aspect(size[0] / size[1]);
-        const Matrix projection(Matrix::perspective(fovy, aspect, 1.0f, 10.0f));
+            // Move the first sphere, which carries the second one with it
+            const GLfloat *const location(window.getLocation());
+            const RigidMatrix r(RigidMatrix::rotate(static_cast<GLfloat>(window.getTime()), 0.0f, 1.0f, 0.0f));
+            scene.setLocal(0, RigidMatrix::translate(location[0], location[1], 0.0f) * r);
 
-        // Calculate the model transformation matrix
-        const GLfloat *const location(window.getLocation());
-        const Matrix r(Matrix::rotate(static_cast<GLfloat>(glfwGetTime()), 0.0f, 1.0f, 0.0f));
-        const Matrix model(Matrix::translate(location[0], location[1], 0.0f) * r);
+            // Recompute only the objects that moved, and move their bounding spheres
+            updatedObjects += scene.update();
+            for (const std::uint32_t k : scene.getUpdated()) {
+                const RigidMatrix &m(scene.getWorld(k));
+                bounds.set(k, {m[12], m[13], m[14], boundingRadius});
+                if (bvh.size() > 0) {
+                    bvh.refit(bounds.span(), k);
+                }
+            }
+        }
 
-        // Calculate the view transformation matrix
-        const Matrix view(Matrix::lookat(3.0f, 4.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f));
+        // Collect the visible objects before any drawing
+        std::size_t visibleCount;
+        {
+            TRACE_SCOPE("cull");
+            const auto start(std::chrono::steady_clock::now());
+            visibleCount = Frustum(projection * view).cull(bounds.span(), visible.data());
+            cullTime += std::chrono::steady_clock::now() - start;
+            visibleObjects += visibleCount;
+        }
 
-        // Storage location of the transformation matrix of the normal vectors.
-        GLfloat normalMatrix[9];
+        // Leave out the visible objects hidden behind the nearest ones
+        if (occlusion) {
+            TRACE_SCOPE("occlusion");
+            const auto start(std::chrono::steady_clock::now());
+            const auto distance([&](std::uint32_t k) {
+                const Vector c(bounds[k]);
+                const GLfloat dx(c[0] - eye[12]), dy(c[1] - eye[13]), dz(c[2] - eye[14]);
+                return dx * dx + dy * dy + dz * dz;
+            });
+            occluders.assign(visible.begin(), visible.begin() + visibleCount);
+            const std::size_t n(std::min(occluderCount, visibleCount));
+            std::partial_sort(occluders.begin(), occluders.begin() + n, occluders.end(),
+                              [&](std::uint32_t a, std::uint32_t b) { return distance(a) < distance(b); });
 
-        // Calculate the model view transformation matrix
-        const Matrix modelview(view * model);
+            // Rasterize the occluders and test the others against them
+            occlusion->begin(projection * view);
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::uint32_t k(occluders[i]);
+                occlusion->addOccluder(scene.getWorld(k), occluderVertex.data(), occluderIndex.data(),
+                                       occluderIndex.size());
+            }
+            occlusion->render();
+            const std::size_t count(occlusion->cull(bounds.span(), visible.data(), visibleCount));
+            occludedObjects += visibleCount - count;
+            visibleCount = count;
+            occlusionTime += std::chrono::steady_clock::now() - start;
+        }
 
-        // Calculate the transformation matrix of normal vector
-        modelview.getNormalMatrix(normalMatrix);
+        // Pick the object under the cursor with a ray from the near plane to the far plane through it
+        if (window.isClicked() || pickEveryFrame) {
+            TRACE_SCOPE("pick");
+            const auto start(std::chrono::steady_clock::now());
+            const GLfloat *const cursor(pickEveryFrame ? pickPoint : window.getCursor());
+            const Matrix inverse((projection * view).inverse());
+            Vector front(inverse * Vector{cursor[0], cursor[1], -1.0f, 1.0f});
+            Vector back(inverse * Vector{cursor[0], cursor[1], 1.0f, 1.0f});
+            for (int i = 0; i < 3; ++i) {
+                front[i] /= front[3];
+                back[i] /= back[3];
+            }
+            const GLfloat direction[] = {back[0] - front[0], back[1] - front[1], back[2] - front[2]};
+            pickedAny = bvh.intersect(bounds.span(), front.data(), direction, picked);
+            pickTime += std::chrono::steady_clock::now() - start;
+            ++picks;
 
-        // Set a value to uniform variable
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, projection.data());
-        glUniformMatrix4fv(modelviewLoc, 1, GL_FALSE, modelview.data());
-        glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, normalMatrix);
-        for (int i = 0; i < Lcount; ++i) {
-            glUniform4fv(LposLoc + i, 1, (view * Lpos[i]).data());
+            if (!pickEveryFrame) {
+                if (pickedAny) {
+                    std::cout << "Picked object " << picked.index << " at " << picked.distance << std::endl;
+                } else {
+                    std::cout << "Picked nothing" << std::endl;
+                }
+            }
         }
-        glUniform3fv(LambLoc, Lcount, Lamb);
-        glUniform3fv(LdiffLoc, Lcount, Ldiff);
-        glUniform3fv(LspecLoc, Lcount, Lspec);
 
-        // Drawing shape
-        shape->draw();
+        // Update the camera data only when the projection has changed
+        if (projectionChanged) {
+            TRACE_SCOPE("uniforms");
+            Camera cameraData;
+            std::copy(projection.data(), projection.data() + 16, cameraData.projection);
+            camera.set(cameraData);
+        }
 
-        // Calculate the 2nd model view transformation matrix
-        const Matrix modelview1(modelview * Matrix::translate(0.0f, 0.0f, 3.0f));
+        // Assign the lights to the clusters of this projection
+        if (lightCluster && (projectionChanged || lightsChanged)) {
+            TRACE_SCOPE("light clusters");
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            lightCluster->update(projection, static_cast<GLfloat>(viewport[2]), static_cast<GLfloat>(viewport[3]));
+        }
 
-        // Calculate the 2nd transformation matrix of normal vector
-        modelview1.getNormalMatrix(normalMatrix);
+        // Select the levels of detail of the visible objects by their size on the screen
+        const auto prepareStart(std::chrono::steady_clock::now());
+        {
+            TRACE_SCOPE("levels");
+            const GLfloat height(window.getSize()[1]);
+            jobs.parallelFor(visibleCount, 256, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t v = begin; v < end; ++v) {
+                    const std::uint32_t k(visible[v]);
+                    level[k] = shape.select(
+                        LodShape::projectedRadius(projection, scene.getModelview(k), boundingRadius, height),
+                        level[k]);
+                }
+            });
 
-        // Set a value to uniform variable
-        glUniformMatrix4fv(modelviewLoc, 1, GL_FALSE, modelview1.data());
-        glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, normalMatrix);
+            // Group the visible objects by level in the order they were found
+            levelStart.assign(shape.size() + 1, 0);
+            for (std::size_t v = 0; v < visibleCount; ++v) {
+                const int l(level[visible[v]]);
+                ++levelStart[l + 1];
+                drawnTriangles += shape.getTriangleCount(l);
+            }
+            std::partial_sum(levelStart.begin(), levelStart.end(), levelStart.begin());
+            std::vector<std::size_t> next(levelStart.begin(), levelStart.end() - 1);
+            for (std::size_t v = 0; v < visibleCount; ++v) {
+                byLevel[next[level[visible[v]]]++] = visible[v];
+            }
+            ++drawnFrames;
+        }
 
-        // Drawing shape
-        shape->draw();
+        // Program object of the instanced drawing, 0 while it is being built
+        const GLuint instancedProgram(lightCluster ? clusterProgram : instancing ? instanceProgram : 0);
+
+        if (instancedProgram != 0) {
+            // Start using shader program for instanced drawing
+            GlState::useProgram(instancedProgram);
+
+            // Pack the transformation matrices of the visible objects into the instance attributes on all threads
+            {
+                TRACE_SCOPE("instances");
+                batch.resize(visibleCount);
+                jobs.parallelFor(visibleCount, 256, [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        const std::uint32_t k(byLevel[i]);
+                        const GLfloat *const m(scene.getModelview(k).data()), *const n(scene.getNormalMatrix(k));
+                        std::copy(m, m + 16, batch[i].modelview);
+                        std::copy(n, n + 9, batch[i].normalMatrix);
+                    }
+                });
+            }
+            prepareTime += std::chrono::steady_clock::now() - prepareStart;
+
+            // Drawing the visible objects of each level at once
+            timer.begin("draw");
+            for (int l = 0; l < shape.size(); ++l) {
+                const std::size_t count(levelStart[l + 1] - levelStart[l]);
+                if (count > 0) {
+                    TRACE_SCOPE("draw");
+                    instances.update(batch.data() + levelStart[l], static_cast<GLsizei>(count));
+                    shape[l].drawInstanced(instances);
+                }
+            }
+            timer.end();
+        } else {
+            prepareTime += std::chrono::steady_clock::now() - prepareStart;
+
+            // Start using shader program
+            GlState::useProgram(program);
+
+            // Drawing each visible object
+            timer.begin("draw");
+            for (std::size_t v = 0; v < visibleCount; ++v) {
+                TRACE_SCOPE("draw");
+                const std::uint32_t k(visible[v]);
+
+                // Set a value to uniform variable
+                GlState::uniformMatrix4fv(modelviewLoc, scene.getModelview(k).data());
+                GlState::uniformMatrix3fv(normalMatrixLoc, scene.getNormalMatrix(k));
+
+                // Drawing shape
+                shape[level[k]].draw();
+            }
+            timer.end();
+        }
 
         // Replace the color buffer
-        window.swapBuffers();
+        {
+            TRACE_SCOPE("swap");
+
+            // Nothing is swapped offscreen, so there is no pass to measure
+            if (!headless) {
+                timer.begin("swap");
+            }
+            window.swapBuffers();
+            timer.end();
+        }
+
+        // Count the state calls of this frame
+        const GlState::Counters frameCalls(GlState::endFrame());
+        stateCalls.issued += frameCalls.issued;
+        stateCalls.skipped += frameCalls.skipped;
+    }
+
+    // Report the time per frame of each number of lights of the sweep, the last one ends with the loop
+    if (lightSweep) {
+        glFinish();
+        if (sweepTimes.size() < std::size(sweepCounts)) {
+            const long frames((sweepFrame - 1) % sweepFrames + 1);
+            sweepTimes.push_back(
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sweepStart).count() /
+                frames);
+        }
+        std::cout << "lights  ms/frame" << std::endl;
+        for (std::size_t i = 0; i < sweepTimes.size(); ++i) {
+            std::cout << std::setw(6) << sweepCounts[i] << "  " << sweepTimes[i] << std::endl;
+        }
+    }
+
+    // Report the speed of culling and the objects left
+    if (sceneCount > 0 && drawnFrames > 0) {
+        const double ms(std::chrono::duration<double, std::milli>(cullTime).count());
+        std::cout << "culling: " << static_cast<double>(objectCount * drawnFrames) / ms << " objects/ms, "
+                  << visibleObjects / drawnFrames << " of " << objectCount << " visible on average" << std::endl;
+    }
+
+    // Report the objects whose transformations were recomputed, only the ones that moved
+    if (sceneCount > 0 && drawnFrames > 0) {
+        std::cout << "transforms: " << updatedObjects / drawnFrames << " of " << objectCount
+                  << " objects recomputed per frame on average" << std::endl;
+    }
+
+    // Report the time preparing the drawing, which is spread over the threads
+    if (sceneCount > 0 && drawnFrames > 0) {
+        std::cout << "prepare: " << std::chrono::duration<double, std::milli>(prepareTime).count() / drawnFrames
+                  << " ms per frame on " << jobs.size() << " threads" << std::endl;
+    }
+
+    // Report the speed of occlusion culling and the objects it hid
+    if (occlusion && drawnFrames > 0) {
+        std::cout << "occlusion: " << occludedObjects / drawnFrames << " more objects hidden in "
+                  << std::chrono::duration<double, std::milli>(occlusionTime).count() / drawnFrames
+                  << " ms per frame on average" << std::endl;
+    }
+
+    // Report the time of picking and the object under the point
+    if (pickEveryFrame && picks > 0) {
+        std::cout << "picking: " << std::chrono::duration<double, std::micro>(pickTime).count() / picks
+                  << " us per pick, ";
+        if (pickedAny) {
+            std::cout << "object " << picked.index << " at " << picked.distance << std::endl;
+        } else {
+            std::cout << "nothing" << std::endl;
+        }
+    }
+
+    // Report the triangles actually drawn, which follow the size of the spheres on the screen
+    if (lod && drawnFrames > 0) {
+        std::cout << drawnTriangles / drawnFrames << " triangles drawn per frame on average" << std::endl;
+    }
+
+    // Report the state calls passed to OpenGL and the redundant ones left out
+    if (headless && drawnFrames > 0) {
+        std::cout << "state: " << static_cast<double>(stateCalls.issued) / drawnFrames << " calls issued and "
+                  << static_cast<double>(stateCalls.skipped) / drawnFrames << " skipped per frame on average"
+                  << std::endl;
+    }
+
+    // Report the GPU time of each drawing pass, including the frames still in flight
+    if (timer) {
+        timer.finish();
+        timer.report(std::cout);
+    }
+
+    // Save the CPU trace
+    if (traceFile != nullptr && !Trace::save(traceFile)) {
+        std::cerr << "Error: Can't write trace file: " << traceFile << std::endl;
     }
 }
@@ -0,0 +1,163 @@
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Write a mesh as a Wavefront OBJ text file with a normal for each vertex
+//   path  : OBJ file name
+//   vertex: Vertex attributes
+//   index : Indices of the triangles
+static bool writeObj(const char *path, const std::vector<Object::Vertex> &vertex, const std::vector<GLuint> &index) {
+    std::ofstream file(path);
+    for (const Object::Vertex &v : vertex) {
+        file << "v " << v.position[0] << ' ' << v.position[1] << ' ' << v.position[2] << '\n';
+    }
+    for (const Object::Vertex &v : vertex) {
+        file << "vn " << v.normal[0] << ' ' << v.normal[1] << ' ' << v.normal[2] << '\n';
+    }
+    for (std::size_t i = 0; i + 2 < index.size(); i += 3) {
+        file << 'f';
+        for (std::size_t j = i; j < i + 3; ++j) {
+            file << ' ' << index[j] + 1 << "//" << index[j] + 1;
+        }
+        file << '\n';
+    }
+    if (!file.flush()) {
+        std::cerr << "Error: Can't write OBJ file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Seconds since a time
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    // Command line options
+    //   --mesh name     : Shape written, sphere, cube, torus, cylinder or plane
+    //   --divisions NxM : Number of divisions of the shape, only N is used for the cube
+    //   --import file   : Convert an OBJ or PLY file instead of a procedural shape
+    //   --obj file      : Also write the shape as a Wavefront OBJ text file
+    //   --threads count : Number of threads importing a file, every hardware thread by default
+    //   --bench mesh obj: Compare loading a mesh file with importing the same shape from an OBJ or PLY file
+    std::string_view meshName("sphere");
+    int divisions[2]{256, 128};
+    const char *importFile(nullptr);
+    const char *objFile(nullptr);
+    unsigned threads(0);
+    const char *output(nullptr);
+    const char *bench[2]{};
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--mesh" && i + 1 < argc && Mesh::isShape(argv[i + 1])) {
+            meshName = argv[++i];
+        } else if (arg == "--divisions" && i + 1 < argc) {
+            std::sscanf(argv[++i], "%dx%d", &divisions[0], &divisions[1]);
+        } else if (arg == "--import" && i + 1 < argc) {
+            importFile = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--obj" && i + 1 < argc) {
+            objFile = argv[++i];
+        } else if (arg == "--bench" && i + 2 < argc) {
+            bench[0] = argv[++i];
+            bench[1] = argv[++i];
+        } else if (arg[0] != '-' && output == nullptr) {
+            output = argv[i];
+        } else {
+            output = nullptr;
+            bench[0] = nullptr;
+            break;
+        }
+    }
+    if (output == nullptr && bench[0] == nullptr) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--mesh sphere|cube|torus|cylinder|plane] [--divisions NxM] [--import file] [--obj file]"
+                  << " output.mesh\n"
+                  << "       " << argv[0] << " [--threads count] --bench file.mesh file.obj" << std::endl;
+        return 1;
+    }
+
+    // Threads importing a file
+    JobSystem jobs(threads);
+
+    // Time to get the vertices ready to upload from both files
+    if (bench[0] != nullptr) {
+        auto start(std::chrono::steady_clock::now());
+        const MeshFile mesh(bench[0]);
+        if (!mesh) {
+            return 1;
+        }
+
+        // Touch every page the upload reads
+        GLfloat sum(0.0f);
+        for (GLsizei k = 0; k < mesh.getVertexCount(); ++k) {
+            sum += mesh.getVertices()[k].position[0];
+        }
+        for (GLsizei k = 0; k < mesh.getIndexCount(); k += 1024) {
+            sum += static_cast<GLfloat>(mesh.getIndices()[k]);
+        }
+        const double mapped(since(start));
+
+        start = std::chrono::steady_clock::now();
+        MeshImporter importer(jobs);
+        if (!importer.load(bench[1])) {
+            return 1;
+        }
+        const double imported(since(start));
+
+        std::cout << mesh.getVertexCount() << " vertices and " << mesh.getIndexCount() << " indices\n"
+                  << "mesh file: " << mapped * 1000.0 << " ms\n"
+                  << "importer : " << imported * 1000.0 << " ms (" << imported / mapped << " times slower)"
+                  << std::endl;
+
+        // Both files must hold the same finite mesh, which also keeps the reads of the mapped pages
+        return importer.getVertices().size() == static_cast<std::size_t>(mesh.getVertexCount()) &&
+                       importer.getIndices().size() == static_cast<std::size_t>(mesh.getIndexCount()) &&
+                       std::isfinite(sum)
+                   ? 0
+                   : 1;
+    }
+
+    // Imported mesh, written from the arrays of the importer
+    MeshImporter importer(jobs);
+    std::vector<Object::Vertex> generatedVertex;
+    std::vector<GLuint> generatedIndex;
+    if (importFile != nullptr) {
+        const auto start(std::chrono::steady_clock::now());
+        if (!importer.load(importFile)) {
+            return 1;
+        }
+        std::cout << importFile << " imported in " << since(start) * 1000.0 << " ms" << std::endl;
+    } else {
+        // Procedural mesh
+        const std::unique_ptr<const Mesh> mesh(Mesh::create(meshName, divisions[0], divisions[1]));
+        generatedVertex.resize(mesh->getVertexCount());
+        generatedIndex.resize(mesh->getIndexCount());
+        mesh->generate(generatedVertex.data(), generatedIndex.data(), jobs);
+    }
+    const std::vector<Object::Vertex> &vertex(importFile != nullptr ? importer.getVertices() : generatedVertex);
+    const std::vector<GLuint> &index(importFile != nullptr ? importer.getIndices() : generatedIndex);
+
+    if (!MeshFile::write(output, vertex.data(), vertex.size(), index.data(), index.size())) {
+        return 1;
+    }
+    if (objFile != nullptr && !writeObj(objFile, vertex, index)) {
+        return 1;
+    }
+    std::cout << vertex.size() << " vertices and " << index.size() << " indices written to " << output << std::endl;
+    return 0;
+}
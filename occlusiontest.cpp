@@ -0,0 +1,58 @@
+#include "OcclusionBuffer.h"
+#include <iostream>
+#include <iterator>
+
+// Check which bounding spheres a square occluder hides, which needs no OpenGL context
+int main() {
+    // Pool of the rasterizer
+    JobSystem jobs(1);
+
+    // Square of side 2 on the xy plane facing the viewpoint on the z axis
+    static constexpr Object::Vertex vertex[] = {
+        {{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{1.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{-1.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    };
+    static constexpr GLuint index[] = {0, 1, 2, 0, 2, 3};
+
+    // Depth buffer of the occluder seen from z = 5 with the aspect ratio of the buffer
+    OcclusionBuffer occlusion(256, 128);
+    occlusion.setJobSystem(&jobs);
+    occlusion.begin(Matrix::perspective(1.0f, 2.0f, 1.0f, 20.0f) *
+                    Matrix::lookat(0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f));
+    occlusion.addOccluder(RigidMatrix::identity(), vertex, index, std::size(index));
+    occlusion.render();
+
+    // Spheres and whether they may be visible
+    static constexpr struct {
+        const char *name;
+        GLfloat x, y, z, r;
+        bool visible;
+    } cases[] = {
+        {"sphere behind the occluder", 0.0f, 0.0f, -2.0f, 0.5f, false},
+        {"sphere in front of the occluder", 0.0f, 0.0f, 2.0f, 0.5f, true},
+        {"sphere poking past the edge of the occluder", 1.2f, 0.0f, -2.0f, 0.5f, true},
+    };
+
+    int failures(0);
+    for (const auto &c : cases) {
+        const bool visible(occlusion.test(c.x, c.y, c.z, c.r));
+        const bool passed(visible == c.visible);
+        std::cout << (passed ? "ok  " : "FAIL") << ' ' << c.name << ": " << (visible ? "visible" : "hidden")
+                  << std::endl;
+        if (!passed) {
+            ++failures;
+        }
+    }
+    if (occlusion.getTriangleCount() != 2) {
+        std::cout << "FAIL " << occlusion.getTriangleCount() << " triangles of the occluder face the viewpoint"
+                  << std::endl;
+        ++failures;
+    }
+    if (failures > 0) {
+        std::cerr << "Error: " << failures << " cases of the occlusion culling are wrong" << std::endl;
+        return 1;
+    }
+    return 0;
+}
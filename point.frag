@@ -1,8 +1,68 @@
 #version 150 core
 #extension GL_ARB_explicit_attrib_location: enable
+#ifndef LCOUNT
+#define LCOUNT 2
+#endif
+#ifndef PER_FRAGMENT
+#define PER_FRAGMENT 0
+#endif
+#ifndef SPECULAR
+#define SPECULAR 1
+#endif
+#ifndef KAMB
+#define KAMB vec3(0.6, 0.6, 0.2)
+#endif
+#ifndef KDIFF
+#define KDIFF vec3(0.6, 0.6, 0.2)
+#endif
+#ifndef KSPEC
+#define KSPEC vec3(0.3, 0.3, 0.3)
+#endif
+#ifndef KSHI
+#define KSHI 30.0
+#endif
+#if PER_FRAGMENT
+const int Lcount = LCOUNT;
+layout (std140) uniform Light {
+    vec4 Lpos[Lcount];
+    vec3 Lamb[Lcount];
+    vec3 Ldiff[Lcount];
+    vec3 Lspec[Lcount];
+};
+const vec3 Kamb = KAMB;
+const vec3 Kdiff = KDIFF;
+const vec3 Kspec = KSPEC;
+const float Kshi = KSHI;
+in vec4 P;
+in vec3 N;
+#else
 in vec3 Idiff;
+#if SPECULAR
 in vec3 Ispec;
+#endif
+#endif
 layout (location = 0) out vec4 fragment;
 void main() {
+#if PER_FRAGMENT
+    vec3 n = normalize(N);
+    vec3 V = -normalize(P.xyz);
+    vec3 Idiff = vec3(0.0);
+#if SPECULAR
+    vec3 Ispec = vec3(0.0);
+#endif
+    for (int i = 0; i < Lcount; ++i) {
+        vec3 L = normalize((Lpos[i] * P.w - P * Lpos[i].w).xyz);
+        vec3 Iamb = Kamb * Lamb[i];
+        Idiff += max(dot(n, L), 0.0) * Kdiff * Ldiff[i] + Iamb;
+#if SPECULAR
+        vec3 H = normalize(L + V);
+        Ispec += pow(max(dot(n, H), 0.0), Kshi) * Kspec * Lspec[i];
+#endif
+    }
+#endif
+#if SPECULAR
     fragment = vec4(Idiff + Ispec, 1.0);
-}
\ No newline at end of file
+#else
+    fragment = vec4(Idiff, 1.0);
+#endif
+}
@@ -1,33 +1,122 @@
 #version 150 core
 #extension GL_ARB_explicit_attrib_location: enable
+#ifndef LCOUNT
+#define LCOUNT 2
+#endif
+#ifndef INSTANCING
+#define INSTANCING 0
+#endif
+#ifndef PER_FRAGMENT
+#define PER_FRAGMENT 0
+#endif
+#ifndef SPECULAR
+#define SPECULAR 1
+#endif
+#ifndef PROCEDURAL
+#define PROCEDURAL 0
+#endif
+#ifndef KAMB
+#define KAMB vec3(0.6, 0.6, 0.2)
+#endif
+#ifndef KDIFF
+#define KDIFF vec3(0.6, 0.6, 0.2)
+#endif
+#ifndef KSPEC
+#define KSPEC vec3(0.3, 0.3, 0.3)
+#endif
+#ifndef KSHI
+#define KSHI 30.0
+#endif
+#if INSTANCING
+layout (location = 2) in mat4 modelview;
+layout (location = 6) in mat3 normalMatrix;
+#else
 uniform mat4 modelview;
-uniform mat4 projection;
 uniform mat3 normalMatrix;
-const int Lcount = 2;
-uniform vec4 Lpos[Lcount];
-uniform vec3 Lamb[Lcount];
-uniform vec3 Ldiff[Lcount];
-uniform vec3 Lspec[Lcount];
-const vec3 Kamb = vec3(0.6, 0.6, 0.2);
-const vec3 Kdiff = vec3(0.6, 0.6, 0.2);
-const vec3 Kspec = vec3(0.3, 0.3, 0.3);
-const float Kshi = 30.0;
-layout (location = 0) in vec4 position;
-layout (location = 1) in vec3 normal;
+#endif
+layout (std140) uniform Camera {
+    mat4 projection;
+};
+#if PROCEDURAL
+uniform ivec2 divisions;
+vec4 position;
+vec3 normal;
+const ivec2 corner[6] = ivec2[6](ivec2(0, 0), ivec2(0, 1), ivec2(1, 1), ivec2(0, 0), ivec2(1, 1), ivec2(1, 0));
+void sphere() {
+    int cell = gl_VertexID / 6;
+    ivec2 k = ivec2(cell % divisions.x, cell / divisions.x) + corner[gl_VertexID % 6];
+    vec2 st = vec2(k) / vec2(divisions);
+    float r = sin(3.141593 * st.t);
+    normal = vec3(r * sin(6.283185 * st.s), cos(3.141593 * st.t), r * cos(6.283185 * st.s));
+    position = vec4(normal, 1.0);
+}
+#else
+layout (location = 0) in vec4 vertexPosition;
+layout (location = 1) in vec3 vertexNormal;
+layout (location = 10) in vec4 decodeScale;
+layout (location = 11) in vec3 decodeOffset;
+vec4 position;
+vec3 normal;
+void decode() {
+    position = vec4(vertexPosition.xyz * decodeScale.xyz + decodeOffset, vertexPosition.w);
+    normal = vertexNormal;
+    if (decodeScale.w > 0.0) {
+        normal.z = 1.0 - abs(normal.x) - abs(normal.y);
+        if (normal.z < 0.0) normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    }
+}
+#endif
+#if PER_FRAGMENT
+out vec4 P;
+out vec3 N;
+void main() {
+#if PROCEDURAL
+    sphere();
+#else
+    decode();
+#endif
+    P = modelview * position;
+    N = normalMatrix * normal;
+    gl_Position = projection * P;
+}
+#else
+const int Lcount = LCOUNT;
+layout (std140) uniform Light {
+    vec4 Lpos[Lcount];
+    vec3 Lamb[Lcount];
+    vec3 Ldiff[Lcount];
+    vec3 Lspec[Lcount];
+};
+const vec3 Kamb = KAMB;
+const vec3 Kdiff = KDIFF;
+const vec3 Kspec = KSPEC;
+const float Kshi = KSHI;
 out vec3 Idiff;
+#if SPECULAR
 out vec3 Ispec;
+#endif
 void main() {
+#if PROCEDURAL
+    sphere();
+#else
+    decode();
+#endif
     vec4 P = modelview * position;
     vec3 N = normalize(normalMatrix * normal);
     vec3 V = -normalize(P.xyz);
     Idiff = vec3(0.0);
+#if SPECULAR
     Ispec = vec3(0.0);
+#endif
     for (int i = 0; i < Lcount; ++i) {
         vec3 L = normalize((Lpos[i] * P.w - P * Lpos[i].w).xyz);
         vec3 Iamb = Kamb * Lamb[i];
         Idiff += max(dot(N, L), 0.0) * Kdiff * Ldiff[i] + Iamb;
+#if SPECULAR
         vec3 H = normalize(L + V);
         Ispec += pow(max(dot(N, H), 0.0), Kshi) * Kspec * Lspec[i];
+#endif
     }
     gl_Position = projection * P;
 }
+#endif